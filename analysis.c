@@ -0,0 +1,1842 @@
+// Offline analysis modes: batch autopilot runs, the batch engine check,
+// tournaments, Monte Carlo statistics, success maps, config sweeps and
+// calibration, difficulty validation, seed search and the trajectory
+// optimizer, with the quantile sketches and heatmaps they report through.
+
+#include <time.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "lander.h"
+
+// --- Quantile sketches ---
+
+void sketch_init(QuantileSketch* sketch, uint32_t seed) {
+    sketch->count = 0;
+    sketch->min = INFINITY;
+    sketch->max = -INFINITY;
+    sketch->height = 1;
+    memset(sketch->size, 0, sizeof(sketch->size));
+    sketch->rng = seed ? seed : 1;
+}
+
+// Lower levels get geometrically less room, as in KLL
+static int sketch_capacity(QuantileSketch* sketch, int level) {
+    int depth = sketch->height - 1 - level;
+    double capacity = SKETCH_K * pow(2.0 / 3.0, depth);
+    return capacity > 8 ? (int)capacity : 8;
+}
+
+static int sketch_compare(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Shellsort: in place and allocation free, unlike qsort, which may malloc
+// and so can't run on the load test's turn path
+static void sketch_sort(double* values, int count) {
+    static const int gaps[] = {301, 132, 57, 23, 10, 4, 1};
+    for (int g = 0; g < (int)(sizeof(gaps) / sizeof(gaps[0])); g++) {
+        int gap = gaps[g];
+        for (int i = gap; i < count; i++) {
+            double value = values[i];
+            int j = i;
+            for (; j >= gap && values[j - gap] > value; j -= gap) values[j] = values[j - gap];
+            values[j] = value;
+        }
+    }
+}
+
+static void sketch_insert(QuantileSketch* sketch, int level, double value);
+
+static void sketch_compact(QuantileSketch* sketch, int level) {
+    double* items = sketch->items[level];
+    int size = sketch->size[level];
+    double promoted[SKETCH_K / 2];
+    int count = 0;
+    sketch_sort(items, size);
+
+    // Every other item of an even-sized prefix moves up at twice the weight;
+    // an odd item out stays behind
+    for (int i = (int)(lander_rand(&sketch->rng) & 1); i < (size & ~1); i += 2) promoted[count++] = items[i];
+    sketch->size[level] = 0;
+    if (size & 1) items[sketch->size[level]++] = items[size - 1];
+
+    if (level + 1 == sketch->height && sketch->height < SKETCH_LEVELS) sketch->height++;
+    int target = level + 1 < SKETCH_LEVELS ? level + 1 : level;
+    for (int i = 0; i < count; i++) sketch_insert(sketch, target, promoted[i]);
+}
+
+static void sketch_insert(QuantileSketch* sketch, int level, double value) {
+    sketch->items[level][sketch->size[level]++] = value;
+    if (sketch->size[level] >= sketch_capacity(sketch, level) || sketch->size[level] == SKETCH_K) {
+        sketch_compact(sketch, level);
+    }
+}
+
+void sketch_add(QuantileSketch* sketch, double value) {
+    sketch->count++;
+    if (value < sketch->min) sketch->min = value;
+    if (value > sketch->max) sketch->max = value;
+    sketch_insert(sketch, 0, value);
+}
+
+void sketch_merge(QuantileSketch* into, const QuantileSketch* from) {
+    into->count += from->count;
+    if (from->min < into->min) into->min = from->min;
+    if (from->max > into->max) into->max = from->max;
+    while (into->height < from->height) into->height++;
+    for (int level = from->height - 1; level >= 0; level--) {
+        for (int i = 0; i < from->size[level]; i++) sketch_insert(into, level, from->items[level][i]);
+    }
+}
+
+typedef struct {
+    double value;
+    double weight;
+} SketchItem;
+
+static int sketch_item_compare(const void* a, const void* b) {
+    return sketch_compare(&((const SketchItem*)a)->value, &((const SketchItem*)b)->value);
+}
+
+// Quantiles q[0..count) into out[]; one sort serves them all
+static void sketch_quantiles(const QuantileSketch* sketch, const double* q, int count, double* out) {
+    int total = 0;
+    for (int level = 0; level < sketch->height; level++) total += sketch->size[level];
+    SketchItem* items = malloc((size_t)(total > 0 ? total : 1) * sizeof(SketchItem));
+    if (!items || total == 0) {
+        for (int i = 0; i < count; i++) out[i] = NAN;
+        free(items);
+        return;
+    }
+
+    double weight_sum = 0;
+    int n = 0;
+    for (int level = 0; level < sketch->height; level++) {
+        for (int i = 0; i < sketch->size[level]; i++) {
+            items[n].value = sketch->items[level][i];
+            items[n++].weight = ldexp(1.0, level);
+        }
+        weight_sum += ldexp(sketch->size[level], level);
+    }
+    qsort(items, (size_t)n, sizeof(SketchItem), sketch_item_compare);
+
+    for (int i = 0; i < count; i++) {
+        // An item of weight w stands for w neighbours centred on it, so rank
+        // it at the middle of its weight rather than the top
+        double target = q[i] * weight_sum, seen = 0;
+        out[i] = items[n - 1].value;
+        for (int j = 0; j < n; j++) {
+            seen += items[j].weight;
+            if (seen - items[j].weight / 2 >= target) {
+                out[i] = items[j].value;
+                break;
+            }
+        }
+        if (q[i] <= 0) out[i] = sketch->min;
+        if (q[i] >= 1) out[i] = sketch->max;
+    }
+    free(items);
+}
+
+static void sketch_report(const char* label, const QuantileSketch* sketch) {
+    static const double q[3] = {0.50, 0.95, 0.99};
+    double value[3];
+    sketch_quantiles(sketch, q, 3, value);
+    printf("%-18s %10.2f %10.2f %10.2f %10.2f %10.2f\n", label, sketch->count ? sketch->min : NAN, value[0],
+           value[1], value[2], sketch->count ? sketch->max : NAN);
+}
+
+// --- Touchdown heatmaps ---
+
+static int heatmap_bin(double value, double lo, double hi, int bins) {
+    int bin = (int)floor((value - lo) / (hi - lo) * bins);
+    return bin < 0 ? 0 : bin >= bins ? bins - 1 : bin;
+}
+
+void heatmap_add(LandingHeatmap* heatmap, double A, double vel_h, double vel_v, int landed) {
+    int x = heatmap_bin(A, -200, 200, HEATMAP_X_BINS);
+    int h = heatmap_bin(vel_h, -5, 5, HEATMAP_H_BINS);
+    int v = heatmap_bin(fabs(vel_v), 0, 10, HEATMAP_V_BINS);
+    heatmap->position[v][x]++;
+    heatmap->velocity[v][h]++;
+    if (landed) {
+        heatmap->position_landed[v][x]++;
+        heatmap->velocity_landed[v][h]++;
+    }
+}
+
+static void heatmap_merge(LandingHeatmap* into, const LandingHeatmap* from) {
+    const uint64_t* source = (const uint64_t*)from;
+    uint64_t* target = (uint64_t*)into;
+    for (size_t i = 0; i < sizeof(LandingHeatmap) / sizeof(uint64_t); i++) target[i] += source[i];
+}
+
+// Log-scaled black-red-yellow-white ramp, slow speeds at the bottom
+static int heatmap_write_image(const char* path, const uint64_t* counts, int width, int height) {
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return -1;
+    uint64_t peak = 1;
+    for (int i = 0; i < width * height; i++) if (counts[i] > peak) peak = counts[i];
+
+    fprintf(fp, "P6\n%d %d\n255\n", width * HEATMAP_SCALE, height * HEATMAP_SCALE);
+    for (int row = height * HEATMAP_SCALE - 1; row >= 0; row--) {
+        for (int col = 0; col < width * HEATMAP_SCALE; col++) {
+            uint64_t count = counts[(row / HEATMAP_SCALE) * width + col / HEATMAP_SCALE];
+            double t = count ? log1p((double)count) / log1p((double)peak) : 0;
+            unsigned char pixel[3] = {
+                (unsigned char)(255 * fmin(1, t * 3)),
+                (unsigned char)(255 * fmin(1, fmax(0, t * 3 - 1))),
+                (unsigned char)(255 * fmin(1, fmax(0, t * 3 - 2))),
+            };
+            fwrite(pixel, 1, 3, fp);
+        }
+    }
+    return fclose(fp);
+}
+
+static int heatmap_write_csv(const char* path, const char* x_name, const uint64_t* counts, const uint64_t* landed,
+                             int width, double x_lo, double x_hi) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) return -1;
+    fprintf(fp, "%s_min,%s_max,impact_speed_min,impact_speed_max,touchdowns,landed\n", x_name, x_name);
+    for (int v = 0; v < HEATMAP_V_BINS; v++) {
+        for (int x = 0; x < width; x++) {
+            uint64_t count = counts[v * width + x];
+            if (!count) continue;
+            double step = (x_hi - x_lo) / width;
+            fprintf(fp, "%g,%g,%g,%g,%llu,%llu\n", x_lo + x * step, x_lo + (x + 1) * step, v * 0.1, (v + 1) * 0.1,
+                    (unsigned long long)count, (unsigned long long)landed[v * width + x]);
+        }
+    }
+    return fclose(fp);
+}
+
+static int heatmap_export(const LandingHeatmap* heatmap, const char* prefix) {
+    char path[1024];
+    int failed = 0;
+    snprintf(path, sizeof(path), "%s-position.ppm", prefix);
+    failed |= heatmap_write_image(path, &heatmap->position[0][0], HEATMAP_X_BINS, HEATMAP_V_BINS);
+    snprintf(path, sizeof(path), "%s-position.csv", prefix);
+    failed |= heatmap_write_csv(path, "A", &heatmap->position[0][0], &heatmap->position_landed[0][0],
+                                HEATMAP_X_BINS, -200, 200);
+    snprintf(path, sizeof(path), "%s-velocity.ppm", prefix);
+    failed |= heatmap_write_image(path, &heatmap->velocity[0][0], HEATMAP_H_BINS, HEATMAP_V_BINS);
+    snprintf(path, sizeof(path), "%s-velocity.csv", prefix);
+    failed |= heatmap_write_csv(path, "vel_h", &heatmap->velocity[0][0], &heatmap->velocity_landed[0][0],
+                                HEATMAP_H_BINS, -5, 5);
+    if (failed) printf("Error: Could not write heatmaps %s-*.\n", prefix);
+    else printf("Heatmaps: %s-position.{ppm,csv} (A x impact speed), %s-velocity.{ppm,csv} (vel_h x impact speed)\n",
+                prefix, prefix);
+    return failed ? -1 : 0;
+}
+
+// Merges per-thread shards (NULL entries skipped) and writes the files
+int heatmap_export_shards(LandingHeatmap** shards, int count, const char* prefix) {
+    LandingHeatmap* total = calloc(1, sizeof(LandingHeatmap));
+    if (!total) {
+        printf("Error: Could not merge heatmaps for %s-*.\n", prefix);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) if (shards[i]) heatmap_merge(total, shards[i]);
+    int status = heatmap_export(total, prefix);
+    free(total);
+    return status;
+}
+
+// Outcome table over LOAD_OUTCOME_* sketches, shared by the load test and the Monte Carlo run
+void report_outcomes(const QuantileSketch* outcomes) {
+    if (outcomes[LOAD_OUTCOME_IMPACT].count == 0) {
+        printf("\nOutcomes: no finished games\n");
+        return;
+    }
+    printf("\nOutcome                   min        p50        p95        p99        max\n");
+    sketch_report("Impact speed (m/s)", &outcomes[LOAD_OUTCOME_IMPACT]);
+    sketch_report("Fuel left", &outcomes[LOAD_OUTCOME_FUEL]);
+    sketch_report("Turns", &outcomes[LOAD_OUTCOME_TURNS]);
+}
+
+// --- Batch autopilot games ---
+
+int run_autopilot_games(const char* plugin_path, int games) {
+    GameConfig config = DEFAULT_GAME_CONFIG;
+    LanderAutopilot* autopilot = lander_autopilot_open(plugin_path);
+    LanderBatch batch;
+    LanderBatchView view;
+    if (!autopilot) return 1;
+
+    int* actions = calloc((size_t)games, sizeof(int));
+    int* results = calloc((size_t)games, sizeof(int));
+    int* outcome = calloc((size_t)games, sizeof(int));
+    if (!actions || !results || !outcome || batch_init(&batch, games) != 0) {
+        printf("Error: Could not allocate %d games.\n", games);
+        free(actions);
+        free(results);
+        free(outcome);
+        lander_autopilot_close(autopilot);
+        return 1;
+    }
+
+    for (int i = 0; i < games; i++) {
+        GameState state;
+        init_game_seeded(&state, &config, (uint32_t)i + 1);
+        batch_load(&batch, i, &state);
+    }
+    batch_view(&batch, &config, &view);
+
+    // Finished landers keep stepping on the ground; only their first result counts
+    LanderDecideFn decide = lander_autopilot_decide_fn(autopilot);
+    int remaining = games, steps = 0;
+    uint64_t decide_ns = 0, step_ns = 0;
+    while (remaining > 0 && steps < 1000) {
+        uint64_t t0 = now_ns();
+        decide(&view, games, actions);
+        uint64_t t1 = now_ns();
+        batch_step(&batch, &config, actions, results);
+        step_ns += now_ns() - t1;
+        decide_ns += t1 - t0;
+        steps++;
+
+        for (int i = 0; i < games; i++) {
+            if (outcome[i] == 0 && results[i] != 0) {
+                outcome[i] = results[i];
+                remaining--;
+            }
+        }
+    }
+
+    int landed = 0;
+    for (int i = 0; i < games; i++) landed += outcome[i] == 1;
+    printf("Autopilot %s: %d games, %d landed (%.1f%%), %d crashed, %d unfinished after %d steps\n",
+           lander_autopilot_name(autopilot), games, landed, 100.0 * landed / games, games - landed - remaining, remaining, steps);
+    printf("Decide: %.1f ns per lander per call (%d calls); physics %.1f ns per lander step\n",
+           (double)decide_ns / ((double)games * steps), steps, (double)step_ns / ((double)games * steps));
+
+    batch_free(&batch);
+    free(actions);
+    free(results);
+    free(outcome);
+    lander_autopilot_close(autopilot);
+    return 0;
+}
+
+// --- Derivative benchmark ---
+
+int run_ad_benchmark(int rollouts) {
+    const int turns = 60, inputs = 2 * turns + 2;
+    GameConfig config = DEFAULT_GAME_CONFIG;
+    double throttles[2 * 60], values[LANDER_ROLLOUT_OUTPUTS], real_out[LANDER_ROLLOUT_OUTPUTS];
+    double* jacobian = malloc((size_t)LANDER_ROLLOUT_OUTPUTS * inputs * sizeof(double));
+    GameState* starts = malloc((size_t)rollouts * sizeof(GameState));
+    if (!jacobian || !starts) {
+        free(jacobian);
+        free(starts);
+        printf("Error: Could not allocate %d rollouts.\n", rollouts);
+        return 1;
+    }
+    for (int i = 0; i < rollouts; i++) init_game_seeded(&starts[i], &config, (uint32_t)i + 1);
+    for (int t = 0; t < turns; t++) {
+        throttles[2 * t] = 0.2 + 0.1 * sin(t * 0.3); // Net descent, touching down within the horizon
+        throttles[2 * t + 1] = 0.2 + 0.1 * cos(t * 0.2);
+    }
+
+    volatile double sink = 0;
+    uint64_t t0 = now_ns();
+    for (int i = 0; i < rollouts; i++) {
+        throttle_rollout(&starts[i], &config, turns, throttles, real_out);
+        sink += real_out[0];
+    }
+    uint64_t t1 = now_ns();
+    for (int i = 0; i < rollouts; i++) {
+        throttle_jacobian(&starts[i], &config, turns, throttles, values, jacobian);
+        sink += jacobian[0];
+    }
+    uint64_t t2 = now_ns();
+    double plain = (t1 - t0) / 1e9, derivative = (t2 - t1) / 1e9;
+
+    // Central differences on one start as a check (the margins' abs and the
+    // touchdown clamp are kinks, so compare the state rows only)
+    double worst = 0, h = 1e-6;
+    throttle_jacobian(&starts[0], &config, turns, throttles, values, jacobian);
+    for (int input = 0; input < 2 * turns; input++) {
+        double plus[LANDER_ROLLOUT_OUTPUTS], minus[LANDER_ROLLOUT_OUTPUTS], saved = throttles[input];
+        throttles[input] = saved + h;
+        throttle_rollout(&starts[0], &config, turns, throttles, plus);
+        throttles[input] = saved - h;
+        throttle_rollout(&starts[0], &config, turns, throttles, minus);
+        throttles[input] = saved;
+        if (plus[1] <= 0 || minus[1] <= 0) continue; // Touchdown moved inside the window
+        for (int o = 0; o < 4; o++) {
+            double numeric = (plus[o] - minus[o]) / (2 * h);
+            worst = fmax(worst, fabs(numeric - jacobian[o * inputs + input]) / fmax(1.0, fabs(numeric)));
+        }
+    }
+
+    printf("Derivative benchmark: %d starts, %d turns, %d inputs (throttles, gravity, engine force)\n", rollouts, turns,
+           inputs);
+    printf("  Plain rollouts:     %10.0f /s\n", rollouts / plain);
+    printf("  Full Jacobians:     %10.0f /s (%d passes of %d directions, %.1fx a plain rollout)\n",
+           rollouts / derivative, (inputs + DUAL_WIDTH - 1) / DUAL_WIDTH, DUAL_WIDTH,
+           derivative / fmax(plain, 1e-9));
+    printf("  Partial derivatives:%10.0f /s\n", (double)rollouts * inputs * LANDER_ROLLOUT_OUTPUTS / derivative);
+    printf("  Max relative error vs central differences: %.2e\n", worst);
+    free(jacobian);
+    free(starts);
+    return 0;
+}
+
+// --- Gradient trajectory optimizer ---
+
+#define OPTIMIZER_TURNS 100      // Longest horizon; the state freezes at touchdown
+#define OPTIMIZER_ITERATIONS 300
+#define OPTIMIZER_MARGIN 0.25    // m/s kept inside both touchdown limits
+#define OPTIMIZER_SMOOTHING 2.0  // Weight on turn-to-turn throttle changes
+#define OPTIMIZER_HORIZON 0.8    // Horizon as a share of the autopilot's flight
+
+typedef struct {
+    GameConfig config;
+    double* fuel;               // Per start: throttle spent before touchdown, -1 if infeasible
+    int* solver_fuel;           // Per start: discrete solver burns, -1 if unsolved
+    SolverWorkspace* workspaces; // Per thread
+    uint64_t* optimizer_ns;     // Per thread
+    uint64_t* solver_ns;        // Per thread
+} TrajectoryOptimization;
+
+// Flies the continuous profile; returns whether it touched down inside both
+// limits within the fuel budget, with the throttle spent and turns flown
+static int optimizer_evaluate(const GameState* start, GameConfig* config, const double* throttles, double* fuel,
+                              int* turns) {
+    double A = start->A, B = start->B, vel_h = start->vel_h, vel_v = start->vel_v;
+    double spent = 0, margin_v, margin_h;
+    int t = 0;
+    for (; t < OPTIMIZER_TURNS && B > 0; t++) {
+        double u_y = throttles[2 * t], u_z = throttles[2 * t + 1];
+        physics_step_real(&A, &B, &vel_h, &vel_v, config->gravity, config->engine_force, start->time_step, 1,
+                          u_y + u_z, u_y - u_z);
+        spent += u_y + u_z;
+    }
+    landing_margins_real(A, vel_h, vel_v, start->radar.terrain_height, config->safe_vertical_speed,
+                         config->safe_horizontal_speed, config->terrain_penalty, &margin_v, &margin_h);
+    *fuel = spent;
+    *turns = t;
+    return B <= 0 && margin_v > 0 && margin_h > 0 && spent <= start->C;
+}
+
+// Penalty method with Adam: minimize spent throttle plus smoothing, while a
+// growing weight pushes the lander to the ground by the end of a fixed
+// horizon with both margins above OPTIMIZER_MARGIN and the total within the
+// fuel budget. A fixed horizon keeps the touchdown turn, and so the
+// objective, from jumping between iterations; a shorter flight than the
+// autopilot's leaves less time for gravity to cost fuel. Turns past the
+// horizon copy its last turn, so a late touchdown keeps braking.
+static void optimizer_task(void* context, int index, int thread) {
+    TrajectoryOptimization* run = context;
+    double throttles[2 * OPTIMIZER_TURNS], moment[2 * OPTIMIZER_TURNS] = {0}, second[2 * OPTIMIZER_TURNS] = {0};
+    double gradient[2 * OPTIMIZER_TURNS], values[LANDER_ROLLOUT_OUTPUTS];
+    double jacobian[LANDER_ROLLOUT_OUTPUTS * (2 * OPTIMIZER_TURNS + 2)];
+    double best_fuel = -1, fuel;
+    int turns;
+    GameState start;
+    GameConfig* config = &run->config;
+
+    init_game_seeded(&start, config, (uint32_t)index + 1);
+    uint64_t t0 = now_ns();
+
+    // Warm start from the built-in autopilot's burns, which already brake late
+    GameState flight = start;
+    flight.engines_on = 1;
+    for (int t = 0; t < OPTIMIZER_TURNS; t++) {
+        char command = flight.B > 0 ? autopilot_command(&flight, config) : 'X';
+        throttles[2 * t] = command == 'Y';
+        throttles[2 * t + 1] = command == 'Z';
+        if (flight.B > 0) update_physics(&flight, config, command);
+    }
+    optimizer_evaluate(&start, config, throttles, &fuel, &turns);
+    turns = (int)(turns * OPTIMIZER_HORIZON + 0.5);
+    if (turns < 1) turns = 1;
+    const int inputs = 2 * turns + 2, active = 2 * turns;
+
+    for (int iteration = 1; iteration <= OPTIMIZER_ITERATIONS; iteration++) {
+        double weight = pow(1000.0, (double)iteration / OPTIMIZER_ITERATIONS);
+        throttle_jacobian(&start, config, turns, throttles, values, jacobian);
+
+        double total = 0;
+        for (int i = 0; i < active; i++) total += throttles[i];
+        double altitude = values[1];
+        double short_v = fmax(0, OPTIMIZER_MARGIN - values[4]), short_h = fmax(0, OPTIMIZER_MARGIN - values[5]);
+        double excess = fmax(0, total - start.C);
+
+        for (int i = 0; i < active; i++) {
+            double g = 1.0 + 2 * weight * excess;
+            g += weight * (0.02 * altitude * jacobian[1 * inputs + i] - 2 * short_v * jacobian[4 * inputs + i] -
+                           2 * short_h * jacobian[5 * inputs + i]);
+            if (i >= 2) g += 2 * OPTIMIZER_SMOOTHING * (throttles[i] - throttles[i - 2]);
+            if (i + 2 < active) g -= 2 * OPTIMIZER_SMOOTHING * (throttles[i + 2] - throttles[i]);
+            gradient[i] = g;
+        }
+
+        const double rate = 0.01, beta1 = 0.9, beta2 = 0.999;
+        for (int i = 0; i < active; i++) {
+            moment[i] = beta1 * moment[i] + (1 - beta1) * gradient[i];
+            second[i] = beta2 * second[i] + (1 - beta2) * gradient[i] * gradient[i];
+            double step = rate * (moment[i] / (1 - pow(beta1, iteration))) /
+                          (sqrt(second[i] / (1 - pow(beta2, iteration))) + 1e-8);
+            throttles[i] = fmin(1.0, fmax(0.0, throttles[i] - step));
+        }
+        // One burn per turn at most: project each (u_y, u_z) onto u_y + u_z <= 1
+        for (int i = 0; i < active; i += 2) {
+            double over = (throttles[i] + throttles[i + 1] - 1) / 2;
+            if (over <= 0) continue;
+            throttles[i] -= over;
+            throttles[i + 1] -= over;
+            if (throttles[i] < 0) throttles[i + 1] += throttles[i], throttles[i] = 0;
+            if (throttles[i + 1] < 0) throttles[i] += throttles[i + 1], throttles[i + 1] = 0;
+        }
+        for (int i = active; i < 2 * OPTIMIZER_TURNS; i++) throttles[i] = throttles[active - 2 + i % 2];
+
+        int flown;
+        if (optimizer_evaluate(&start, config, throttles, &fuel, &flown) && (best_fuel < 0 || fuel < best_fuel)) {
+            best_fuel = fuel;
+        }
+    }
+    run->fuel[index] = best_fuel;
+    uint64_t t1 = now_ns();
+
+    SolverResult result;
+    solve_landing(&run->workspaces[thread], &start, config, &result);
+    run->solver_fuel[index] = result.min_fuel >= 0 && result.min_fuel <= start.C ? result.min_fuel : -1;
+    uint64_t t2 = now_ns();
+
+    run->optimizer_ns[thread] += t1 - t0;
+    run->solver_ns[thread] += t2 - t1;
+}
+
+int run_trajectory_optimizer(int starts, int threads) {
+    TrajectoryOptimization run;
+    int status = 1, workspaces_ready = 0;
+    memset(&run, 0, sizeof(run));
+    run.config = (GameConfig)DEFAULT_GAME_CONFIG;
+    run.fuel = malloc((size_t)starts * sizeof(double));
+    run.solver_fuel = malloc((size_t)starts * sizeof(int));
+    run.workspaces = calloc((size_t)threads, sizeof(SolverWorkspace));
+    run.optimizer_ns = calloc((size_t)threads, sizeof(uint64_t));
+    run.solver_ns = calloc((size_t)threads, sizeof(uint64_t));
+    if (!run.fuel || !run.solver_fuel || !run.workspaces || !run.optimizer_ns || !run.solver_ns) {
+        printf("Error: Could not allocate an optimization over %d starts.\n", starts);
+        goto done;
+    }
+    for (; workspaces_ready < threads; workspaces_ready++) {
+        if (solver_init(&run.workspaces[workspaces_ready], SOLVER_DEFAULT_BEAM) != 0) goto done;
+    }
+
+    uint64_t start = now_ns();
+    work_steal_for(starts, threads, optimizer_task, &run);
+    double elapsed = (now_ns() - start) / 1e9;
+
+    int optimized = 0, solved = 0, both = 0;
+    double optimizer_total = 0, solver_total = 0;
+    uint64_t optimizer_ns = 0, solver_ns = 0;
+    for (int t = 0; t < threads; t++) {
+        optimizer_ns += run.optimizer_ns[t];
+        solver_ns += run.solver_ns[t];
+    }
+    for (int i = 0; i < starts; i++) {
+        optimized += run.fuel[i] >= 0;
+        solved += run.solver_fuel[i] >= 0;
+        if (run.fuel[i] >= 0 && run.solver_fuel[i] >= 0) {
+            both++;
+            optimizer_total += run.fuel[i];
+            solver_total += run.solver_fuel[i];
+        }
+    }
+
+    printf("Trajectory optimization: %d starts on %d threads in %.1f s (%d turns, %d iterations)\n", starts, threads,
+           elapsed, OPTIMIZER_TURNS, OPTIMIZER_ITERATIONS);
+    printf("\nMethod              Landed     Mean fuel*   Time per start\n");
+    printf("Gradient throttles  %5.1f%%   %10.2f   %11.2f ms\n", 100.0 * optimized / starts,
+           both ? optimizer_total / both : 0, optimizer_ns / 1e6 / starts);
+    printf("Discrete solver     %5.1f%%   %10.2f   %11.2f ms\n", 100.0 * solved / starts,
+           both ? solver_total / both : 0, solver_ns / 1e6 / starts);
+    printf("* Over the %d starts both methods land; throttle is in full-burn equivalents\n", both);
+    status = 0;
+
+done:
+    for (int t = 0; t < workspaces_ready; t++) solver_free(&run.workspaces[t]);
+    free(run.fuel);
+    free(run.solver_fuel);
+    free(run.workspaces);
+    free(run.optimizer_ns);
+    free(run.solver_ns);
+    return status;
+}
+
+// --- Difficulty estimator validation ---
+
+#define VALIDATION_BINS 10
+
+typedef struct {
+    GameConfig config;
+    SolverWorkspace* workspaces; // Per thread
+    double* estimate;
+    double* actual;  // Solver burns / initial fuel, (initial_fuel + 1) / initial_fuel when unsolved
+    int8_t* solved;
+    int8_t* exhaustive; // The beam dropped nothing, so actual is the true minimum
+} DifficultyValidation;
+
+static void validation_task(void* context, int index, int thread) {
+    DifficultyValidation* run = context;
+    GameState state;
+    SolverResult result;
+    init_game_seeded(&state, &run->config, (uint32_t)index + 1);
+    solve_landing(&run->workspaces[thread], &state, &run->config, &result);
+    int fuel = run->config.initial_fuel;
+    run->solved[index] = result.min_fuel >= 0 && result.min_fuel <= fuel;
+    run->exhaustive[index] = (int8_t)result.exhaustive;
+    run->estimate[index] = state.difficulty;
+    run->actual[index] = run->solved[index] ? (double)result.min_fuel / fuel : (double)(fuel + 1) / fuel;
+}
+
+static const double* validation_keys; // qsort has no context argument
+
+static int validation_compare(const void* a, const void* b) {
+    double x = validation_keys[*(const int*)a], y = validation_keys[*(const int*)b];
+    return x < y ? -1 : x > y;
+}
+
+// Average ranks, ties sharing the mean of their positions
+static void validation_ranks(const double* values, int count, int* order, double* ranks) {
+    for (int i = 0; i < count; i++) order[i] = i;
+    validation_keys = values;
+    qsort(order, (size_t)count, sizeof(int), validation_compare);
+    for (int i = 0; i < count;) {
+        int j = i;
+        while (j + 1 < count && values[order[j + 1]] == values[order[i]]) j++;
+        for (int k = i; k <= j; k++) ranks[order[k]] = (i + j) / 2.0;
+        i = j + 1;
+    }
+}
+
+static double validation_pearson(const double* x, const double* y, const int8_t* mask, int count) {
+    double n = 0, sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+    for (int i = 0; i < count; i++) {
+        if (mask && !mask[i]) continue;
+        n++;
+        sx += x[i];
+        sy += y[i];
+        sxx += x[i] * x[i];
+        syy += y[i] * y[i];
+        sxy += x[i] * y[i];
+    }
+    double cov = sxy / n - sx / n * sy / n;
+    double var = (sxx / n - sx / n * sx / n) * (syy / n - sy / n * sy / n);
+    return var > 0 ? cov / sqrt(var) : 0;
+}
+
+int run_difficulty_validation(int starts, int threads) {
+    DifficultyValidation run;
+    int status = 1, workspaces_ready = 0;
+    if (starts < VALIDATION_BINS) {
+        printf("Error: Validate at least %d starts.\n", VALIDATION_BINS);
+        return 1;
+    }
+
+    memset(&run, 0, sizeof(run));
+    run.config = (GameConfig)DEFAULT_GAME_CONFIG;
+    run.workspaces = calloc((size_t)threads, sizeof(SolverWorkspace));
+    run.estimate = malloc((size_t)starts * sizeof(double));
+    run.actual = malloc((size_t)starts * sizeof(double));
+    run.solved = malloc((size_t)starts);
+    run.exhaustive = malloc((size_t)starts);
+    int* order = malloc((size_t)starts * sizeof(int));
+    double* estimate_ranks = malloc((size_t)starts * sizeof(double));
+    double* actual_ranks = malloc((size_t)starts * sizeof(double));
+    if (!run.workspaces || !run.estimate || !run.actual || !run.solved || !run.exhaustive || !order ||
+        !estimate_ranks || !actual_ranks) {
+        printf("Error: Could not allocate a validation over %d starts.\n", starts);
+        goto done;
+    }
+    for (; workspaces_ready < threads; workspaces_ready++) {
+        if (solver_init(&run.workspaces[workspaces_ready], SOLVER_DEFAULT_BEAM) != 0) goto done;
+    }
+
+    uint64_t start = now_ns();
+    work_steal_for(starts, threads, validation_task, &run);
+    double elapsed = (now_ns() - start) / 1e9;
+
+    int solved = 0, exhaustive = 0;
+    for (int i = 0; i < starts; i++) {
+        solved += run.solved[i];
+        exhaustive += run.exhaustive[i];
+    }
+    validation_ranks(run.actual, starts, order, actual_ranks);
+    validation_ranks(run.estimate, starts, order, estimate_ranks); // Leaves order sorted by estimate
+
+    printf("Difficulty validation: %d starts solved with a %d-state beam on %d threads in %.1f s (%d solvable)\n",
+           starts, SOLVER_DEFAULT_BEAM, threads, elapsed, solved);
+    printf("Exhaustive searches: %d of %d; the rest give beam upper bounds on the fuel needed\n", exhaustive, starts);
+    printf("Pearson r (solvable starts):  %.3f\n", validation_pearson(run.estimate, run.actual, run.solved, starts));
+    printf("Spearman rho (all starts):    %.3f\n", validation_pearson(estimate_ranks, actual_ranks, NULL, starts));
+
+    // Reliability table over equal-count bins of the estimate; calibration
+    // error is the start-weighted gap between predicted and solver burns
+    double calibration_error = 0;
+    printf("\nEstimate bin        Starts   Mean estimate   Solver burns   Solvable\n");
+    for (int b = 0; b < VALIDATION_BINS; b++) {
+        int lo = (int)((long long)starts * b / VALIDATION_BINS), hi = (int)((long long)starts * (b + 1) / VALIDATION_BINS);
+        double sum_estimate = 0, sum_actual = 0;
+        int bin_solved = 0;
+        for (int k = lo; k < hi; k++) {
+            int i = order[k];
+            if (!run.solved[i]) continue;
+            bin_solved++;
+            sum_estimate += run.estimate[i];
+            sum_actual += run.actual[i];
+        }
+        double mean_estimate = bin_solved ? sum_estimate / bin_solved : 0;
+        double mean_actual = bin_solved ? sum_actual / bin_solved : 0;
+        calibration_error += bin_solved * fabs(mean_estimate - mean_actual);
+        printf("[%6.3f, %6.3f]  %7d   %13.3f   %12.3f   %7.1f%%\n", run.estimate[order[lo]], run.estimate[order[hi - 1]],
+               hi - lo, mean_estimate, mean_actual, 100.0 * bin_solved / (hi - lo));
+    }
+    printf("\nCalibration error (solvable starts): %.3f of the fuel budget\n", solved ? calibration_error / solved : 0);
+
+    int correct = 0;
+    for (int i = 0; i < starts; i++) correct += (run.estimate[i] <= 1) == run.solved[i];
+    printf("Estimate <= 1 predicts solvability: %.1f%% correct\n", 100.0 * correct / starts);
+    status = 0;
+
+done:
+    for (int t = 0; t < workspaces_ready; t++) solver_free(&run.workspaces[t]);
+    free(run.workspaces);
+    free(run.estimate);
+    free(run.actual);
+    free(run.solved);
+    free(run.exhaustive);
+    free(order);
+    free(estimate_ranks);
+    free(actual_ranks);
+    return status;
+}
+
+// --- Seed search ---
+
+#define SEED_BLOCK 4096 // Seeds per work_steal_for task
+#define SEED_LANES 256  // Seeds whose cheap fields are filtered together
+#define SEED_MAX_MATCHES 1000000
+
+enum { SEED_A, SEED_B, SEED_VEL_H, SEED_VEL_V, SEED_CHEAP_FIELDS, // Known before terrain generation
+       SEED_SAFE_X = SEED_CHEAP_FIELDS, SEED_SAFE_SCORE, SEED_DISTANCE, SEED_DIFFICULTY, SEED_FIELDS };
+
+static const char* SEED_FIELD_NAMES[SEED_FIELDS] = {
+    "A", "B", "vel_h", "vel_v", "safe_landing_x", "safe_landing_score", "distance", "difficulty"};
+
+enum { SEED_LT, SEED_LE, SEED_GT, SEED_GE, SEED_EQ, SEED_NE };
+
+typedef struct {
+    GameConfig config;
+    const SeedPredicate* predicates;
+    int predicate_count;
+    int wanted;
+    pthread_mutex_t lock; // Guards found and matches; matches are rare
+    int found;            // Seeds kept, at most wanted
+    uint32_t* matches;    // Lowest matching seeds so far, ascending
+    uint32_t bound;       // Atomic; with wanted kept, the highest of them: no seed above it can get in
+    uint64_t scanned;   // Atomic; seeds whose cheap fields were evaluated
+    uint64_t generated; // Atomic; seeds that needed terrain generation
+} SeedSearch;
+
+// "FIELD OP VALUE", e.g. "safe_landing_score < 40" or "|A - safe_landing_x| > 100"
+int parse_seed_predicate(const char* text, SeedPredicate* predicate) {
+    static const char* OPS[] = {"<", "<=", ">", ">=", "==", "!="};
+    char compact[128];
+    size_t length = 0;
+    for (; *text && length + 1 < sizeof(compact); text++) {
+        if (!isspace((unsigned char)*text)) compact[length++] = *text;
+    }
+    compact[length] = '\0';
+
+    size_t name_length = strcspn(compact, "<>=!");
+    char* op = compact + name_length;
+    char* end;
+    if (*op == '\0') return -1;
+    if (strncmp(compact, "|A-safe_landing_x|", name_length) == 0 && name_length == 18) {
+        predicate->field = SEED_DISTANCE;
+    } else {
+        predicate->field = -1;
+        for (int f = 0; f < SEED_FIELDS; f++) {
+            if (strlen(SEED_FIELD_NAMES[f]) == name_length && strncmp(compact, SEED_FIELD_NAMES[f], name_length) == 0) {
+                predicate->field = f;
+            }
+        }
+        if (predicate->field < 0) return -1;
+    }
+
+    int op_length = op[1] == '=' ? 2 : 1;
+    predicate->op = -1;
+    for (int o = 0; o < 6; o++) {
+        if ((int)strlen(OPS[o]) == op_length && strncmp(op, OPS[o], (size_t)op_length) == 0) predicate->op = o;
+    }
+    if (predicate->op < 0) return -1;
+    predicate->value = strtod(op + op_length, &end);
+    return end == op + op_length || *end ? -1 : 0;
+}
+
+static int seed_compare_value(double value, const SeedPredicate* predicate) {
+    switch (predicate->op) {
+        case SEED_LT: return value < predicate->value;
+        case SEED_LE: return value <= predicate->value;
+        case SEED_GT: return value > predicate->value;
+        case SEED_GE: return value >= predicate->value;
+        case SEED_EQ: return value == predicate->value;
+        default: return value != predicate->value;
+    }
+}
+
+// The switch sits outside the loops so each loop is a plain vector compare
+static void seed_filter(const double* values, const SeedPredicate* predicate, uint8_t* pass) {
+    const double limit = predicate->value;
+    switch (predicate->op) {
+        case SEED_LT: for (int i = 0; i < SEED_LANES; i++) pass[i] &= values[i] < limit; break;
+        case SEED_LE: for (int i = 0; i < SEED_LANES; i++) pass[i] &= values[i] <= limit; break;
+        case SEED_GT: for (int i = 0; i < SEED_LANES; i++) pass[i] &= values[i] > limit; break;
+        case SEED_GE: for (int i = 0; i < SEED_LANES; i++) pass[i] &= values[i] >= limit; break;
+        case SEED_EQ: for (int i = 0; i < SEED_LANES; i++) pass[i] &= values[i] == limit; break;
+        default: for (int i = 0; i < SEED_LANES; i++) pass[i] &= values[i] != limit; break;
+    }
+}
+
+static void seed_search_task(void* context, int index, int thread) {
+    (void)thread;
+    SeedSearch* search = context;
+    double cheap[SEED_CHEAP_FIELDS][SEED_LANES];
+    uint8_t pass[SEED_LANES];
+    uint64_t generated = 0, scanned = 0;
+
+    for (int lane_start = 0; lane_start < SEED_BLOCK; lane_start += SEED_LANES) {
+        uint32_t first = (uint32_t)index * SEED_BLOCK + (uint32_t)lane_start + 1;
+        if (first > __atomic_load_n(&search->bound, __ATOMIC_RELAXED)) break;
+
+        // The first four draws of init_game_seeded, lane by lane
+        for (int i = 0; i < SEED_LANES; i++) {
+            start_kinematics(first + (uint32_t)i, &cheap[SEED_A][i], &cheap[SEED_B][i], &cheap[SEED_VEL_H][i],
+                             &cheap[SEED_VEL_V][i]);
+            pass[i] = first + (uint32_t)i != 0; // Seed 0 is past the end of the range
+        }
+        for (int p = 0; p < search->predicate_count; p++) {
+            if (search->predicates[p].field < SEED_CHEAP_FIELDS) {
+                seed_filter(cheap[search->predicates[p].field], &search->predicates[p], pass);
+            }
+        }
+        scanned += SEED_LANES;
+
+        // Terrain only for the seeds that survived
+        for (int i = 0; i < SEED_LANES; i++) {
+            if (!pass[i]) continue;
+            GameState state;
+            uint32_t seed = first + (uint32_t)i;
+            init_game_seeded(&state, &search->config, seed);
+            generated++;
+            double fields[SEED_FIELDS] = {state.A, state.B, state.vel_h, state.vel_v, state.radar.safe_landing_x,
+                                          state.radar.safe_landing_score, fabs(state.A - state.radar.safe_landing_x),
+                                          state.difficulty};
+            int match = 1;
+            for (int p = 0; match && p < search->predicate_count; p++) {
+                match = seed_compare_value(fields[search->predicates[p].field], &search->predicates[p]);
+            }
+            if (!match) continue;
+
+            // Keep the lowest `wanted` seeds, so the result doesn't depend on
+            // which thread got where first
+            pthread_mutex_lock(&search->lock);
+            if (search->found < search->wanted || seed < search->matches[search->wanted - 1]) {
+                int slot = search->found < search->wanted ? search->found++ : search->wanted - 1;
+                for (; slot > 0 && search->matches[slot - 1] > seed; slot--) {
+                    search->matches[slot] = search->matches[slot - 1];
+                }
+                search->matches[slot] = seed;
+                if (search->found == search->wanted) {
+                    __atomic_store_n(&search->bound, search->matches[search->wanted - 1], __ATOMIC_RELAXED);
+                }
+            }
+            pthread_mutex_unlock(&search->lock);
+        }
+    }
+    __atomic_fetch_add(&search->scanned, scanned, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&search->generated, generated, __ATOMIC_RELAXED);
+}
+
+int run_seed_search(const SeedPredicate* predicates, int predicate_count, int wanted, int threads) {
+    SeedSearch search;
+    if (wanted < 1 || wanted > SEED_MAX_MATCHES) {
+        printf("Error: --matches must be between 1 and %d.\n", SEED_MAX_MATCHES);
+        return 1;
+    }
+    memset(&search, 0, sizeof(search));
+    search.config = (GameConfig)DEFAULT_GAME_CONFIG;
+    search.predicates = predicates;
+    search.predicate_count = predicate_count;
+    search.wanted = wanted;
+    search.bound = UINT32_MAX;
+    search.matches = malloc((size_t)wanted * sizeof(uint32_t));
+    if (!search.matches) {
+        printf("Error: Could not allocate %d matches.\n", wanted);
+        return 1;
+    }
+    pthread_mutex_init(&search.lock, NULL);
+
+    // Seeds 1 .. 2^32 - 1; once enough matches are kept, blocks above the
+    // highest of them return at once
+    uint64_t start = now_ns();
+    work_steal_for((int)((1ull << 32) / SEED_BLOCK), threads, seed_search_task, &search);
+    double elapsed = (now_ns() - start) / 1e9;
+    pthread_mutex_destroy(&search.lock);
+
+    int found = search.found;
+    printf("Seed search: %llu seeds scanned, %llu needed terrain, %d matched, on %d threads in %.2f s\n",
+           (unsigned long long)search.scanned, (unsigned long long)search.generated, found, threads, elapsed);
+    if (found > 0) printf("\n      Seed       A      B   vel_h  vel_v  Safe x  Safety  Difficulty\n");
+    for (int m = 0; m < found; m++) {
+        GameState state;
+        init_game_seeded(&state, &search.config, search.matches[m]);
+        printf("%10u  %6.0f  %5.0f  %6.1f  %5.0f  %6.0f  %6.1f  %9.0f%%\n", search.matches[m], state.A, state.B,
+               state.vel_h, state.vel_v, state.radar.safe_landing_x, state.radar.safe_landing_score,
+               100 * state.difficulty);
+    }
+    free(search.matches);
+    return found > 0 ? 0 : 1;
+}
+
+// --- Batch engine check ---
+
+#define BATCH_CHECK_BLOCK 256
+
+// Flies seeded games through batch_step and, lander by lander, through
+// simulate_turn with the batch's rules (burns ignite the engines, radar does
+// not advance time), and compares every turn. Actions are the built-in
+// autopilot's with one in four replaced at random, so landings, crashes,
+// radar and empty tanks all occur.
+int run_batch_check(int games) {
+    GameConfig config = DEFAULT_GAME_CONFIG;
+    LanderBatch batch;
+    LanderBatchView view;
+    int actions[BATCH_CHECK_BLOCK], results[BATCH_CHECK_BLOCK];
+    int8_t finished[BATCH_CHECK_BLOCK];
+    uint32_t rng = 1;
+    long long turns = 0;
+    LanderAutopilot* autopilot = lander_autopilot_open(NULL);
+    if (!autopilot) return 1;
+    LanderDecideFn decide = lander_autopilot_decide_fn(autopilot);
+    GameState* states = malloc(BATCH_CHECK_BLOCK * sizeof(GameState));
+    if (!states || batch_init(&batch, BATCH_CHECK_BLOCK) != 0) {
+        printf("Error: Could not allocate the batch check.\n");
+        free(states);
+        lander_autopilot_close(autopilot);
+        return 1;
+    }
+
+    int status = 0;
+    for (int first = 0; first < games && status == 0; first += BATCH_CHECK_BLOCK) {
+        int count = games - first < BATCH_CHECK_BLOCK ? games - first : BATCH_CHECK_BLOCK;
+        batch.count = count;
+        for (int i = 0; i < count; i++) {
+            init_game_seeded(&states[i], &config, (uint32_t)(first + i) + 1);
+            batch_load(&batch, i, &states[i]);
+            finished[i] = 0;
+        }
+        batch_view(&batch, &config, &view);
+
+        int remaining = count;
+        for (int step = 0; remaining > 0 && step < 1000 && status == 0; step++) {
+            decide(&view, count, actions);
+            for (int i = 0; i < count; i++) {
+                if (lander_rand(&rng) % 4 == 0) actions[i] = (int)(lander_rand(&rng) % 4);
+            }
+            batch_step(&batch, &config, actions, results);
+
+            for (int i = 0; i < count && status == 0; i++) {
+                if (finished[i]) continue;
+                GameState* state = &states[i];
+                int result = 0;
+                if (actions[i] == LANDER_ACTION_RADAR) {
+                    if (state->C > 0) {
+                        state->radar.active = 1;
+                        state->radar.turns_remaining = 3;
+                        state->C--;
+                    } else {
+                        state->engines_on = 0;
+                    }
+                } else {
+                    if (actions[i] != LANDER_ACTION_DRIFT) state->engines_on = 1;
+                    result = simulate_turn(state, &config, actions[i] == LANDER_ACTION_LEFT_BURN ? 'Y'
+                                                           : actions[i] == LANDER_ACTION_RIGHT_BURN ? 'Z' : 'X');
+                }
+                turns++;
+
+                int radar_turns = state->radar.active ? state->radar.turns_remaining : 0;
+                if (result != results[i] || state->A != batch.A[i] || state->B != batch.B[i] ||
+                    state->vel_h != batch.vel_h[i] || state->vel_v != batch.vel_v[i] || state->C != batch.C[i] ||
+                    state->engines_on != batch.engines_on[i] || radar_turns != batch.radar_turns[i]) {
+                    printf("** FAILED: seed %d, turn %d: batch_step and simulate_turn disagree **\n", first + i + 1,
+                           step + 1);
+                    status = 1;
+                }
+                if (result != 0) {
+                    finished[i] = 1;
+                    remaining--;
+                }
+            }
+        }
+    }
+    if (status == 0) printf("Batch check: %d games, %lld turns: batch_step matches simulate_turn\n", games, turns);
+    batch_free(&batch);
+    free(states);
+    lander_autopilot_close(autopilot);
+    return status;
+}
+
+// --- Block flight ---
+
+#define FLIGHT_BLOCK 256       // Games per task, flown together as one batch
+#define FLIGHT_MAX_TURNS 1000  // Games still flying after this many turns stay unfinished
+
+// One per thread, reused by every block that thread flies
+typedef struct {
+    LanderBatch batch;
+    int actions[FLIGHT_BLOCK];
+    int results[FLIGHT_BLOCK];
+    GameState starts[FLIGHT_BLOCK]; // Scratch for callers that build their starts per block
+} BatchLane;
+
+// Called once per game as it lands (result 1) or crashes (-1), with the
+// batch holding its final state at slot `game` and the turns it flew
+typedef void (*FlightFinishFn)(void* context, int thread, const LanderBatch* batch, int game, int result, int turns);
+
+void batch_lanes_destroy(BatchLane* lanes, int threads) {
+    if (!lanes) return;
+    for (int t = 0; t < threads; t++) batch_free(&lanes[t].batch);
+    free(lanes);
+}
+
+BatchLane* batch_lanes_create(int threads) {
+    BatchLane* lanes = calloc((size_t)threads, sizeof(BatchLane));
+    if (!lanes) return NULL;
+    for (int t = 0; t < threads; t++) {
+        if (batch_init(&lanes[t].batch, FLIGHT_BLOCK) != 0) {
+            batch_lanes_destroy(lanes, t);
+            return NULL;
+        }
+    }
+    return lanes;
+}
+
+// Flies count games from starts with the autopilot until every one has
+// finished or FLIGHT_MAX_TURNS have passed
+void fly_block(BatchLane* lane, GameConfig* config, LanderAutopilot* autopilot, GameState* starts, int count,
+               FlightFinishFn on_finish, void* context, int thread) {
+    int8_t done[FLIGHT_BLOCK] = {0};
+    LanderBatchView view;
+
+    lane->batch.count = count;
+    for (int i = 0; i < count; i++) batch_load(&lane->batch, i, &starts[i]);
+    batch_view(&lane->batch, config, &view);
+
+    LanderDecideFn decide = lander_autopilot_decide_fn(autopilot);
+    int remaining = count;
+    for (int turn = 1; remaining > 0 && turn <= FLIGHT_MAX_TURNS; turn++) {
+        decide(&view, count, lane->actions);
+        batch_step(&lane->batch, config, lane->actions, lane->results);
+        for (int i = 0; i < count; i++) {
+            if (done[i] || lane->results[i] == 0) continue;
+            done[i] = 1;
+            remaining--;
+            on_finish(context, thread, &lane->batch, i, lane->results[i], turn);
+        }
+    }
+}
+
+// --- Bot tournament ---
+
+typedef struct {
+    GameConfig config;
+    GameState* starts; // One per seed, terrain included, shared by every bot
+    int seeds;
+    LanderAutopilot** bots;
+    int bot_count;
+    BatchLane* lanes; // Per thread
+    int8_t* outcome; // [bot][seed]: 1 landed, -1 crashed, 0 unfinished
+    int16_t* fuel;   // [bot][seed]: fuel left at touchdown
+} Tournament;
+
+static void tournament_generate(void* context, int index, int thread) {
+    (void)thread;
+    Tournament* tournament = context;
+    init_game_seeded(&tournament->starts[index], &tournament->config, (uint32_t)index + 1);
+}
+
+// Results of one (bot, block) task
+typedef struct {
+    int8_t* outcome;
+    int16_t* fuel;
+} TournamentBlock;
+
+static void tournament_finish(void* context, int thread, const LanderBatch* batch, int game, int result, int turns) {
+    (void)thread;
+    (void)turns;
+    TournamentBlock* block = context;
+    block->outcome[game] = (int8_t)result;
+    block->fuel[game] = (int16_t)batch->C[game];
+}
+
+// Tasks interleave bots so all bots fly a block of seeds at about the same time
+static void tournament_task(void* context, int index, int thread) {
+    Tournament* tournament = context;
+    int bot = index % tournament->bot_count;
+    int first = index / tournament->bot_count * FLIGHT_BLOCK;
+    int count = tournament->seeds - first < FLIGHT_BLOCK ? tournament->seeds - first : FLIGHT_BLOCK;
+    TournamentBlock block = {tournament->outcome + (size_t)bot * tournament->seeds + first,
+                             tournament->fuel + (size_t)bot * tournament->seeds + first};
+
+    memset(block.outcome, 0, (size_t)count);
+    fly_block(&tournament->lanes[thread], &tournament->config, tournament->bots[bot], &tournament->starts[first],
+              count, tournament_finish, &block, thread);
+}
+
+typedef struct {
+    int bot;
+    double rate, fuel;
+} TournamentRank;
+
+static int tournament_compare(const void* a, const void* b) {
+    const TournamentRank* x = a;
+    const TournamentRank* y = b;
+    if (x->rate != y->rate) return x->rate < y->rate ? 1 : -1;
+    return x->fuel < y->fuel ? 1 : x->fuel > y->fuel ? -1 : 0;
+}
+
+int run_tournament(const char** plugin_paths, int plugin_count, int seeds, int threads) {
+    Tournament tournament;
+    int status = 1;
+    memset(&tournament, 0, sizeof(tournament));
+    tournament.config = (GameConfig)DEFAULT_GAME_CONFIG;
+    tournament.seeds = seeds;
+    tournament.bots = calloc((size_t)plugin_count + 1, sizeof(LanderAutopilot*));
+    tournament.starts = malloc((size_t)seeds * sizeof(GameState));
+    tournament.lanes = batch_lanes_create(threads);
+    tournament.outcome = calloc((size_t)(plugin_count + 1) * seeds, sizeof(int8_t));
+    tournament.fuel = calloc((size_t)(plugin_count + 1) * seeds, sizeof(int16_t));
+    TournamentRank* ranks = calloc((size_t)plugin_count + 1, sizeof(TournamentRank));
+    if (!tournament.bots || !tournament.starts || !tournament.lanes || !tournament.outcome || !tournament.fuel || !ranks) {
+        printf("Error: Could not allocate a tournament over %d seeds.\n", seeds);
+        goto done;
+    }
+
+    for (int b = -1; b < plugin_count; b++) {
+        LanderAutopilot* bot = lander_autopilot_open(b < 0 ? NULL : plugin_paths[b]);
+        if (!bot) goto done;
+        tournament.bots[tournament.bot_count++] = bot;
+    }
+
+    uint64_t t0 = now_ns();
+    parallel_for(seeds, threads, tournament_generate, &tournament);
+    uint64_t t1 = now_ns();
+    int blocks = (seeds + FLIGHT_BLOCK - 1) / FLIGHT_BLOCK;
+    work_steal_for(blocks * tournament.bot_count, threads, tournament_task, &tournament);
+    uint64_t t2 = now_ns();
+
+    printf("Tournament: %d bots x %d seeds on %d threads (terrain %.1f ms, games %.1f ms)\n", tournament.bot_count,
+           seeds, threads, (t1 - t0) / 1e6, (t2 - t1) / 1e6);
+
+    for (int b = 0; b < tournament.bot_count; b++) {
+        int landed = 0;
+        double fuel = 0;
+        for (int s = 0; s < seeds; s++) {
+            if (tournament.outcome[(size_t)b * seeds + s] == 1) {
+                landed++;
+                fuel += tournament.fuel[(size_t)b * seeds + s];
+            }
+        }
+        ranks[b] = (TournamentRank){b, (double)landed / seeds, landed ? fuel / landed : 0};
+    }
+    qsort(ranks, (size_t)tournament.bot_count, sizeof(TournamentRank), tournament_compare);
+
+    // Wilson interval per bot; the gap to the leader uses paired differences
+    // over the shared seeds, which cancels out how hard each seed is
+    const double z = 1.96;
+    int leader = ranks[0].bot;
+    printf("\nRank  Bot                   Landed   95%% CI            Fuel left   vs leader (paired 95%% CI)\n");
+    for (int r = 0; r < tournament.bot_count; r++) {
+        int b = ranks[r].bot;
+        double p = ranks[r].rate, n = seeds;
+        double center = (p + z * z / (2 * n)) / (1 + z * z / n);
+        double half = z * sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+
+        double sum = 0, sum_sq = 0;
+        for (int s = 0; s < seeds; s++) {
+            double d = (tournament.outcome[(size_t)b * seeds + s] == 1) - (tournament.outcome[(size_t)leader * seeds + s] == 1);
+            sum += d;
+            sum_sq += d * d;
+        }
+        double mean = sum / n;
+        double se = seeds > 1 ? sqrt(fmax(sum_sq / n - mean * mean, 0) * n / (n - 1) / n) : 0;
+
+        printf("%-5d %-20s %6.2f%%   [%5.2f%%, %5.2f%%]   %8.1f", r + 1, lander_autopilot_name(tournament.bots[b]),
+               100 * p, 100 * (center - half), 100 * (center + half), ranks[r].fuel);
+        if (r == 0) printf("   -\n");
+        else printf("   %+.2f%% [%+.2f%%, %+.2f%%]\n", 100 * mean, 100 * (mean - z * se), 100 * (mean + z * se));
+    }
+    status = 0;
+
+done:
+    for (int b = 0; b < tournament.bot_count; b++) lander_autopilot_close(tournament.bots[b]);
+    free(tournament.bots);
+    free(tournament.starts);
+    batch_lanes_destroy(tournament.lanes, threads);
+    free(tournament.outcome);
+    free(tournament.fuel);
+    free(ranks);
+    return status;
+}
+
+// --- Monte Carlo outcome statistics ---
+
+typedef struct {
+    GameConfig config;
+    long long games;
+    LanderAutopilot* autopilot;
+    BatchLane* lanes;      // Per thread
+    QuantileSketch* sketches;   // Per thread: LOAD_OUTCOME_COUNT sketches
+    uint64_t* landed;           // Per thread
+    LandingHeatmap** heatmaps;  // Per thread, with --heatmap
+} MonteCarlo;
+
+static void monte_carlo_finish(void* context, int thread, const LanderBatch* batch, int game, int result, int turns) {
+    MonteCarlo* run = context;
+    QuantileSketch* sketches = &run->sketches[thread * LOAD_OUTCOME_COUNT];
+    run->landed[thread] += result == 1;
+    sketch_add(&sketches[LOAD_OUTCOME_IMPACT], fabs(batch->vel_v[game]));
+    sketch_add(&sketches[LOAD_OUTCOME_FUEL], batch->C[game]);
+    sketch_add(&sketches[LOAD_OUTCOME_TURNS], turns);
+    if (run->heatmaps) {
+        heatmap_add(run->heatmaps[thread], batch->A[game], batch->vel_h[game], batch->vel_v[game], result == 1);
+    }
+}
+
+static void monte_carlo_task(void* context, int index, int thread) {
+    MonteCarlo* run = context;
+    BatchLane* lane = &run->lanes[thread];
+    long long first = (long long)index * FLIGHT_BLOCK;
+    int count = run->games - first < FLIGHT_BLOCK ? (int)(run->games - first) : FLIGHT_BLOCK;
+    for (int i = 0; i < count; i++) init_game_seeded(&lane->starts[i], &run->config, (uint32_t)(first + i + 1));
+    fly_block(lane, &run->config, run->autopilot, lane->starts, count, monte_carlo_finish, run, thread);
+}
+
+int run_monte_carlo(const char* plugin_path, long long games, int threads, const char* heatmap_prefix) {
+    MonteCarlo run;
+    int status = 1, ran = 0;
+    long long blocks = (games + FLIGHT_BLOCK - 1) / FLIGHT_BLOCK;
+    if (blocks > 0x7FFFFFFF) {
+        printf("Error: At most %lld games per run.\n", 0x7FFFFFFFll * FLIGHT_BLOCK);
+        return 1;
+    }
+
+    memset(&run, 0, sizeof(run));
+    run.config = (GameConfig)DEFAULT_GAME_CONFIG;
+    run.games = games;
+    run.autopilot = lander_autopilot_open(plugin_path);
+    run.lanes = batch_lanes_create(threads);
+    run.sketches = malloc((size_t)threads * LOAD_OUTCOME_COUNT * sizeof(QuantileSketch));
+    run.landed = calloc((size_t)threads, sizeof(uint64_t));
+    QuantileSketch* total = malloc(LOAD_OUTCOME_COUNT * sizeof(QuantileSketch));
+    if (!run.autopilot || !run.lanes || !run.sketches || !run.landed || !total) goto done;
+    if (heatmap_prefix) {
+        run.heatmaps = calloc((size_t)threads, sizeof(LandingHeatmap*));
+        if (!run.heatmaps) goto done;
+        for (int t = 0; t < threads; t++) {
+            run.heatmaps[t] = calloc(1, sizeof(LandingHeatmap));
+            if (!run.heatmaps[t]) goto done;
+        }
+    }
+    for (int i = 0; i < threads * LOAD_OUTCOME_COUNT; i++) sketch_init(&run.sketches[i], (uint32_t)i + 1);
+
+    uint64_t start = now_ns();
+    work_steal_for((int)blocks, threads, monte_carlo_task, &run);
+    double elapsed = (now_ns() - start) / 1e9;
+
+    // Per-thread sketches merge into one; memory never depended on the game count
+    uint64_t landed = 0;
+    for (int t = 0; t < threads; t++) landed += run.landed[t];
+    for (int k = 0; k < LOAD_OUTCOME_COUNT; k++) {
+        sketch_init(&total[k], (uint32_t)k + 1);
+        for (int t = 0; t < threads; t++) sketch_merge(&total[k], &run.sketches[t * LOAD_OUTCOME_COUNT + k]);
+    }
+
+    printf("Monte Carlo: %lld games with %s on %d threads in %.2f s (%.0f games/s)\n", games,
+           lander_autopilot_name(run.autopilot), threads, elapsed, games / elapsed);
+    printf("Landed %llu (%.2f%%); %llu finished\n", (unsigned long long)landed, 100.0 * landed / games,
+           (unsigned long long)total[LOAD_OUTCOME_IMPACT].count);
+    report_outcomes(total);
+    printf("\nSketches: %zu KB per thread regardless of run length\n",
+           LOAD_OUTCOME_COUNT * sizeof(QuantileSketch) / 1024);
+    ran = 1;
+    status = run.heatmaps && heatmap_export_shards(run.heatmaps, threads, heatmap_prefix) != 0;
+
+done:
+    if (!ran) printf("Error: Could not set up the Monte Carlo run.\n");
+    lander_autopilot_close(run.autopilot);
+    batch_lanes_destroy(run.lanes, threads);
+    free(run.sketches);
+    free(run.landed);
+    for (int t = 0; run.heatmaps && t < threads; t++) free(run.heatmaps[t]);
+    free(run.heatmaps);
+    free(total);
+    return status;
+}
+
+// --- Success-probability map over starting conditions ---
+
+// init_game's ranges on a coarse grid: A in 10 m steps, B in 50 m steps,
+// vel_h in 0.5 m/s steps and vel_v in 1 m/s steps
+#define MAP_A 20
+#define MAP_B 10
+#define MAP_VH 20
+#define MAP_VV 20
+#define MAP_CELLS (MAP_A * MAP_B * MAP_VH * MAP_VV)
+#define MAP_BLOCKS ((MAP_CELLS + FLIGHT_BLOCK - 1) / FLIGHT_BLOCK)
+#define MAP_CHECKPOINT_SECONDS 10
+
+typedef struct {
+    GameConfig config;
+    int seeds;
+    LanderAutopilot* autopilot;   // NULL = use the solver's verdict
+    const char* policy;
+    GameState* terrains;          // One per seed, generated once
+    BatchLane* lanes;        // Per thread
+    SolverWorkspace* workspaces;  // Per thread, solver mode only
+    uint8_t* outcome;             // [seed][cell]: 1 landed, 2 crashed or unsolved
+    uint8_t* task_done;           // [seed * MAP_BLOCKS + block]
+    int* pending;                 // Task numbers in the current round
+    uint64_t deadline;            // Next checkpoint; tasks not yet started wait for it
+} SuccessMap;
+
+static void map_cell_start(GameState* state, const GameState* terrain, int cell) {
+    int v = cell % MAP_VV, h = cell / MAP_VV % MAP_VH;
+    int b = cell / (MAP_VV * MAP_VH) % MAP_B, a = cell / (MAP_VV * MAP_VH * MAP_B);
+    *state = *terrain;
+    state->A = -100 + 10.0 * a;
+    state->B = 100 + 50.0 * b;
+    state->vel_h = -5 + 0.5 * h;
+    state->vel_v = -15 + 1.0 * v;
+    state->prev_vel_h = state->vel_h;
+    state->prev_vel_v = state->vel_v;
+}
+
+static void map_generate(void* context, int index, int thread) {
+    (void)thread;
+    SuccessMap* map = context;
+    init_game_seeded(&map->terrains[index], &map->config, (uint32_t)index + 1);
+}
+
+static void map_finish(void* context, int thread, const LanderBatch* batch, int game, int result, int turns) {
+    (void)thread;
+    (void)batch;
+    (void)turns;
+    uint8_t* outcome = context;
+    outcome[game] = result == 1 ? 1 : 2;
+}
+
+// One task is one block of cells on one seed's terrain
+static void map_task(void* context, int index, int thread) {
+    SuccessMap* map = context;
+    int task = map->pending[index];
+    int seed = task / MAP_BLOCKS, first = task % MAP_BLOCKS * FLIGHT_BLOCK;
+    int count = MAP_CELLS - first < FLIGHT_BLOCK ? MAP_CELLS - first : FLIGHT_BLOCK;
+    uint8_t* outcome = map->outcome + (size_t)seed * MAP_CELLS + first;
+    GameState state;
+
+    if (now_ns() >= map->deadline) return; // Left pending until after the checkpoint
+    if (!map->autopilot) {
+        for (int i = 0; i < count; i++) {
+            SolverResult result;
+            map_cell_start(&state, &map->terrains[seed], first + i);
+            solve_landing(&map->workspaces[thread], &state, &map->config, &result);
+            outcome[i] = result.min_fuel >= 0 && result.min_fuel <= state.C ? 1 : 2;
+        }
+        map->task_done[task] = 1;
+        return;
+    }
+
+    BatchLane* lane = &map->lanes[thread];
+    for (int i = 0; i < count; i++) {
+        map_cell_start(&lane->starts[i], &map->terrains[seed], first + i);
+        outcome[i] = 0;
+    }
+    fly_block(lane, &map->config, map->autopilot, lane->starts, count, map_finish, outcome, thread);
+    for (int i = 0; i < count; i++) if (outcome[i] == 0) outcome[i] = 2;
+    map->task_done[task] = 1;
+}
+
+// Written to a temporary file and renamed, so a kill never leaves a torn checkpoint
+static int map_save_checkpoint(SuccessMap* map, const char* path) {
+    char temp[1040];
+    snprintf(temp, sizeof(temp), "%s.tmp", path);
+    FILE* fp = fopen(temp, "wb");
+    if (!fp) return -1;
+    fprintf(fp, "moon-lander-map 1 %s %d %d\n", map->policy, map->seeds, MAP_CELLS);
+    size_t tasks = (size_t)map->seeds * MAP_BLOCKS, cells = (size_t)map->seeds * MAP_CELLS;
+    int failed = fwrite(map->task_done, 1, tasks, fp) != tasks || fwrite(map->outcome, 1, cells, fp) != cells;
+    failed |= fclose(fp) != 0;
+    if (failed || rename(temp, path) != 0) {
+        remove(temp);
+        return -1;
+    }
+    return 0;
+}
+
+// Returns the number of finished tasks restored, or -1 if the file is for a different run
+static int map_load_checkpoint(SuccessMap* map, const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return 0;
+    char header[256], expected[256];
+    snprintf(expected, sizeof(expected), "moon-lander-map 1 %s %d %d\n", map->policy, map->seeds, MAP_CELLS);
+    size_t tasks = (size_t)map->seeds * MAP_BLOCKS, cells = (size_t)map->seeds * MAP_CELLS;
+    int valid = fgets(header, sizeof(header), fp) && strcmp(header, expected) == 0 &&
+                fread(map->task_done, 1, tasks, fp) == tasks && fread(map->outcome, 1, cells, fp) == cells;
+    fclose(fp);
+    if (!valid) {
+        memset(map->task_done, 0, tasks);
+        return -1;
+    }
+    int restored = 0;
+    for (size_t t = 0; t < tasks; t++) restored += map->task_done[t];
+    return restored;
+}
+
+static double map_rate(SuccessMap* map, int cell) {
+    int landed = 0;
+    for (int s = 0; s < map->seeds; s++) landed += map->outcome[(size_t)s * MAP_CELLS + cell] == 1;
+    return (double)landed / map->seeds;
+}
+
+// Small multiples: one vel_h x vel_v tile per (A, B), A across and B up,
+// each tile with vel_h across and vel_v up. Red = never lands, green = always.
+static int map_write_image(SuccessMap* map, const char* path) {
+    const int scale = 2, tile = MAP_VH * scale + 1;
+    const int width = MAP_A * tile + 1, height = MAP_B * (MAP_VV * scale + 1) + 1;
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return -1;
+    fprintf(fp, "P6\n%d %d\n255\n", width, height);
+    for (int y = height - 1; y >= 0; y--) {
+        for (int x = 0; x < width; x++) {
+            unsigned char pixel[3] = {64, 64, 64}; // Tile borders
+            int tx = x % tile, ty = y % (MAP_VV * scale + 1);
+            if (tx != 0 && ty != 0 && x < width - 1 && y < height - 1) {
+                int a = x / tile, b = y / (MAP_VV * scale + 1);
+                int h = (tx - 1) / scale, v = (ty - 1) / scale;
+                double p = map_rate(map, ((a * MAP_B + b) * MAP_VH + h) * MAP_VV + v);
+                pixel[0] = (unsigned char)(255 * (1 - p));
+                pixel[1] = (unsigned char)(255 * p);
+                pixel[2] = 0;
+            }
+            fwrite(pixel, 1, 3, fp);
+        }
+    }
+    return fclose(fp);
+}
+
+static int map_write_csv(SuccessMap* map, const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) return -1;
+    fprintf(fp, "A,B,vel_h,vel_v,success_rate\n");
+    for (int cell = 0; cell < MAP_CELLS; cell++) {
+        GameState state;
+        map_cell_start(&state, &map->terrains[0], cell);
+        fprintf(fp, "%g,%g,%g,%g,%.4f\n", state.A, state.B, state.vel_h, state.vel_v, map_rate(map, cell));
+    }
+    return fclose(fp);
+}
+
+int run_success_map(const char* prefix, const char* plugin_path, int use_solver, int seeds, int threads) {
+    SuccessMap map;
+    char path[1024];
+    int status = 1, allocated = 0, workspaces_ready = 0;
+    size_t tasks = (size_t)seeds * MAP_BLOCKS;
+    if (seeds < 1 || tasks > 0x7FFFFFFF) {
+        printf("Error: --map-seeds must be between 1 and %d.\n", 0x7FFFFFFF / MAP_BLOCKS);
+        return 1;
+    }
+
+    memset(&map, 0, sizeof(map));
+    map.config = (GameConfig)DEFAULT_GAME_CONFIG;
+    map.seeds = seeds;
+    if (!use_solver) {
+        map.autopilot = lander_autopilot_open(plugin_path);
+        if (!map.autopilot) return 1;
+    }
+    map.policy = map.autopilot ? lander_autopilot_name(map.autopilot) : "solver";
+    map.terrains = malloc((size_t)seeds * sizeof(GameState));
+    map.lanes = use_solver ? NULL : batch_lanes_create(threads);
+    map.workspaces = calloc((size_t)threads, sizeof(SolverWorkspace));
+    map.outcome = calloc((size_t)seeds * MAP_CELLS, 1);
+    map.task_done = calloc(tasks, 1);
+    map.pending = malloc(tasks * sizeof(int));
+    if (!map.terrains || (!use_solver && !map.lanes) || !map.workspaces || !map.outcome || !map.task_done ||
+        !map.pending) {
+        goto done;
+    }
+    for (; use_solver && workspaces_ready < threads; workspaces_ready++) {
+        if (solver_init(&map.workspaces[workspaces_ready], SOLVER_DEFAULT_BEAM) != 0) goto done;
+    }
+    allocated = 1;
+
+    snprintf(path, sizeof(path), "%s.ckpt", prefix);
+    int restored = map_load_checkpoint(&map, path);
+    if (restored < 0) {
+        printf("Error: %s belongs to a different map; delete it to start over.\n", path);
+        goto done;
+    }
+    if (restored > 0) printf("Resuming from %s: %d of %zu tasks already done\n", path, restored, tasks);
+
+    // Terrain is the expensive part of a start, so each seed's is built once
+    // and every cell on that seed only overwrites position and velocity
+    parallel_for(seeds, threads, map_generate, &map);
+
+    printf("Success map: %d cells x %d seeds with %s on %d threads\n", MAP_CELLS, seeds, map.policy, threads);
+    uint64_t start = now_ns();
+    int finished = restored, round = 0;
+    size_t next = 0;
+    map.deadline = start + MAP_CHECKPOINT_SECONDS * 1000000000ull;
+    for (;;) {
+        // Rounds keep every thread busy. Tasks past the deadline don't start,
+        // so a checkpoint waits at most one task, however long the round.
+        for (; next < tasks && round < threads * 8; next++) {
+            if (!map.task_done[next]) map.pending[round++] = (int)next;
+        }
+        if (round == 0) break;
+        work_steal_for(round, threads, map_task, &map);
+        int left = 0;
+        for (int i = 0; i < round; i++) {
+            if (map.task_done[map.pending[i]]) finished++;
+            else map.pending[left++] = map.pending[i];
+        }
+        round = left;
+
+        uint64_t now = now_ns();
+        if (now >= map.deadline || (round == 0 && next == tasks)) {
+            if (map_save_checkpoint(&map, path) != 0) printf("Warning: Could not write checkpoint %s.\n", path);
+            map.deadline = now + MAP_CHECKPOINT_SECONDS * 1000000000ull;
+            printf("  %d/%zu tasks (%.1f%%), %.0f s\n", finished, tasks, 100.0 * finished / tasks, (now - start) / 1e9);
+            fflush(stdout);
+        }
+    }
+
+    long long landed = 0;
+    for (size_t i = 0; i < (size_t)seeds * MAP_CELLS; i++) landed += map.outcome[i] == 1;
+    printf("Overall success rate: %.2f%%\n", 100.0 * landed / ((double)seeds * MAP_CELLS));
+
+    int failed = 0;
+    snprintf(path, sizeof(path), "%s.ppm", prefix);
+    failed |= map_write_image(&map, path);
+    snprintf(path, sizeof(path), "%s.csv", prefix);
+    failed |= map_write_csv(&map, path);
+    if (failed) {
+        printf("Error: Could not write %s.ppm and %s.csv.\n", prefix, prefix);
+        goto done;
+    }
+    printf("Wrote %s.ppm (vel_h x vel_v tiles, A across, B up) and %s.csv\n", prefix, prefix);
+    status = 0;
+
+done:
+    if (!allocated) printf("Error: Could not allocate a success map over %d seeds.\n", seeds);
+    for (int t = 0; t < workspaces_ready; t++) solver_free(&map.workspaces[t]);
+    lander_autopilot_close(map.autopilot);
+    free(map.terrains);
+    batch_lanes_destroy(map.lanes, threads);
+    free(map.workspaces);
+    free(map.outcome);
+    free(map.task_done);
+    free(map.pending);
+    return status;
+}
+
+// --- GameConfig sweeps ---
+
+// Sweep ranges around the moon defaults (1.6, 3.0, 50)
+#define SWEEP_GRAVITY_MIN 1.0
+#define SWEEP_GRAVITY_MAX 3.0
+#define SWEEP_ENGINE_MIN 2.0
+#define SWEEP_ENGINE_MAX 5.0
+#define SWEEP_FUEL_MIN 20
+#define SWEEP_FUEL_MAX 80
+
+typedef struct {
+    GameConfig config;
+    double rate, fuel; // Success rate and mean fuel left on landing
+} SweepRow;
+
+typedef struct {
+    GameConfig* configs;
+    int config_count;
+    int games;
+    int blocks;           // Per config
+    GameState* starts;    // Shared by every config; only the fuel is replaced
+    LanderAutopilot* autopilot;
+    BatchLane* lanes; // Per thread
+    int* landed;          // Per task, summed per config afterwards
+    long long* fuel_left; // Per task
+} Sweep;
+
+static void sweep_generate(void* context, int index, int thread) {
+    (void)thread;
+    Sweep* sweep = context;
+    GameConfig config = DEFAULT_GAME_CONFIG;
+    init_game_seeded(&sweep->starts[index], &config, (uint32_t)index + 1);
+}
+
+// Results of one (config, block) task
+typedef struct {
+    int landed;
+    long long fuel_left;
+} SweepBlock;
+
+static void sweep_finish(void* context, int thread, const LanderBatch* batch, int game, int result, int turns) {
+    (void)thread;
+    (void)turns;
+    SweepBlock* block = context;
+    if (result == 1) {
+        block->landed++;
+        block->fuel_left += batch->C[game];
+    }
+}
+
+static void sweep_task(void* context, int index, int thread) {
+    Sweep* sweep = context;
+    BatchLane* lane = &sweep->lanes[thread];
+    GameConfig* config = &sweep->configs[index / sweep->blocks];
+    int first = index % sweep->blocks * FLIGHT_BLOCK;
+    int count = sweep->games - first < FLIGHT_BLOCK ? sweep->games - first : FLIGHT_BLOCK;
+    SweepBlock block = {0, 0};
+
+    for (int i = 0; i < count; i++) {
+        lane->starts[i] = sweep->starts[first + i];
+        lane->starts[i].C = config->initial_fuel;
+    }
+    fly_block(lane, config, sweep->autopilot, lane->starts, count, sweep_finish, &block, thread);
+    sweep->landed[index] = block.landed;
+    sweep->fuel_left[index] = block.fuel_left;
+}
+
+static int sweep_compare(const void* a, const void* b) {
+    const SweepRow* x = a;
+    const SweepRow* y = b;
+    if (x->rate != y->rate) return x->rate < y->rate ? 1 : -1;
+    return x->fuel < y->fuel ? 1 : x->fuel > y->fuel ? -1 : 0;
+}
+
+// grid > 0 sweeps grid^3 evenly spaced configs, otherwise `samples` random ones
+int run_config_sweep(const char* plugin_path, int grid, int samples, int games, int threads) {
+    Sweep sweep;
+    int status = 1;
+    int count = grid > 0 ? grid * grid * grid : samples;
+    memset(&sweep, 0, sizeof(sweep));
+    sweep.games = games;
+    sweep.blocks = (games + FLIGHT_BLOCK - 1) / FLIGHT_BLOCK;
+    if (count < 1 || games < 1 || (long long)count * sweep.blocks > 0x7FFFFFFF) {
+        printf("Error: Invalid sweep size.\n");
+        return 1;
+    }
+
+    sweep.config_count = count;
+    sweep.configs = malloc((size_t)count * sizeof(GameConfig));
+    sweep.starts = malloc((size_t)games * sizeof(GameState));
+    sweep.lanes = batch_lanes_create(threads);
+    sweep.landed = calloc((size_t)count * sweep.blocks, sizeof(int));
+    sweep.fuel_left = calloc((size_t)count * sweep.blocks, sizeof(long long));
+    SweepRow* rows = malloc((size_t)count * sizeof(SweepRow));
+    if (!sweep.configs || !sweep.starts || !sweep.lanes || !sweep.landed || !sweep.fuel_left || !rows) {
+        printf("Error: Could not allocate a sweep of %d configs.\n", count);
+        goto done;
+    }
+    sweep.autopilot = lander_autopilot_open(plugin_path);
+    if (!sweep.autopilot) goto done;
+
+    uint32_t rng = 0x5EED5EEDu;
+    for (int c = 0; c < count; c++) {
+        double u[3];
+        if (grid > 0) {
+            int index[3] = {c / (grid * grid), c / grid % grid, c % grid};
+            for (int k = 0; k < 3; k++) u[k] = grid > 1 ? (double)index[k] / (grid - 1) : 0.5;
+        } else {
+            for (int k = 0; k < 3; k++) u[k] = lander_rand(&rng) / 4294967296.0;
+        }
+        sweep.configs[c] = (GameConfig)DEFAULT_GAME_CONFIG;
+        sweep.configs[c].gravity = SWEEP_GRAVITY_MIN + u[0] * (SWEEP_GRAVITY_MAX - SWEEP_GRAVITY_MIN);
+        sweep.configs[c].engine_force = SWEEP_ENGINE_MIN + u[1] * (SWEEP_ENGINE_MAX - SWEEP_ENGINE_MIN);
+        sweep.configs[c].initial_fuel = (int)lround(SWEEP_FUEL_MIN + u[2] * (SWEEP_FUEL_MAX - SWEEP_FUEL_MIN));
+    }
+
+    // Every config flies the same seeds, so differences come from the config alone
+    uint64_t start = now_ns();
+    parallel_for(games, threads, sweep_generate, &sweep);
+    work_steal_for(count * sweep.blocks, threads, sweep_task, &sweep);
+    double elapsed = (now_ns() - start) / 1e9;
+
+    for (int c = 0; c < count; c++) {
+        long long landed = 0, fuel_left = 0;
+        for (int b = 0; b < sweep.blocks; b++) {
+            landed += sweep.landed[c * sweep.blocks + b];
+            fuel_left += sweep.fuel_left[c * sweep.blocks + b];
+        }
+        rows[c] = (SweepRow){sweep.configs[c], (double)landed / games, landed ? (double)fuel_left / landed : 0};
+    }
+    qsort(rows, (size_t)count, sizeof(SweepRow), sweep_compare);
+
+    printf("Sweep: %d configs x %d games with %s on %d threads in %.2f s\n", count, games,
+           lander_autopilot_name(sweep.autopilot), threads, elapsed);
+    printf("\nGravity  Engine  Fuel   Landed   Fuel left\n");
+    for (int c = 0; c < count; c++) {
+        printf("%7.2f  %6.2f  %4d  %6.2f%%   %9.1f\n", rows[c].config.gravity, rows[c].config.engine_force,
+               rows[c].config.initial_fuel, 100 * rows[c].rate, rows[c].fuel);
+    }
+
+    // Closest configs to typical preset targets
+    static const struct { const char* name; double target; } PRESETS[] = {{"Easy", 0.9}, {"Normal", 0.6}, {"Hard", 0.3}};
+    printf("\nPreset   Target   Gravity  Engine  Fuel   Landed\n");
+    for (int p = 0; p < 3; p++) {
+        int best = 0;
+        for (int c = 1; c < count; c++) {
+            if (fabs(rows[c].rate - PRESETS[p].target) < fabs(rows[best].rate - PRESETS[p].target)) best = c;
+        }
+        printf("%-7s  %5.0f%%   %7.2f  %6.2f  %4d  %6.2f%%\n", PRESETS[p].name, 100 * PRESETS[p].target,
+               rows[best].config.gravity, rows[best].config.engine_force, rows[best].config.initial_fuel,
+               100 * rows[best].rate);
+    }
+    status = 0;
+
+done:
+    lander_autopilot_close(sweep.autopilot);
+    free(sweep.configs);
+    free(sweep.starts);
+    batch_lanes_destroy(sweep.lanes, threads);
+    free(sweep.landed);
+    free(sweep.fuel_left);
+    free(rows);
+    return status;
+}
+
+// --- Touchdown tolerance calibration ---
+
+typedef struct {
+    GameConfig config;    // Candidate tolerances
+    long long games;
+    LanderAutopilot* autopilot;
+    BatchLane* lanes; // Per thread
+    uint64_t* landed;     // Per thread
+} Calibration;
+
+static void calibration_finish(void* context, int thread, const LanderBatch* batch, int game, int result, int turns) {
+    (void)batch;
+    (void)game;
+    (void)turns;
+    Calibration* run = context;
+    run->landed[thread] += result == 1;
+}
+
+static void calibration_task(void* context, int index, int thread) {
+    Calibration* run = context;
+    BatchLane* lane = &run->lanes[thread];
+    long long first = (long long)index * FLIGHT_BLOCK;
+    int count = run->games - first < FLIGHT_BLOCK ? (int)(run->games - first) : FLIGHT_BLOCK;
+    for (int i = 0; i < count; i++) init_game_seeded(&lane->starts[i], &run->config, (uint32_t)(first + i + 1));
+    fly_block(lane, &run->config, run->autopilot, lane->starts, count, calibration_finish, run, thread);
+}
+
+static double calibration_rate(Calibration* run, double scale, int threads) {
+    GameConfig defaults = DEFAULT_GAME_CONFIG;
+    run->config.safe_vertical_speed = defaults.safe_vertical_speed * scale;
+    run->config.safe_horizontal_speed = defaults.safe_horizontal_speed * scale;
+    run->config.terrain_penalty = defaults.terrain_penalty * scale;
+    memset(run->landed, 0, (size_t)threads * sizeof(uint64_t));
+    work_steal_for((int)((run->games + FLIGHT_BLOCK - 1) / FLIGHT_BLOCK), threads, calibration_task, run);
+    uint64_t landed = 0;
+    for (int t = 0; t < threads; t++) landed += run->landed[t];
+    return (double)landed / run->games;
+}
+
+// Scales all three tolerances together, keeping their default proportions,
+// and bisects on the scale. Each candidate flies the same seeds, but policies
+// see the limits in LanderBatchView and may fly differently under them, so
+// the rate need not grow with the scale; a candidate outside the bracket's
+// rates is reported rather than assumed away.
+int run_calibration(const char* plugin_path, double target, long long games, int threads) {
+    Calibration run;
+    int status = 1, allocated = 0, monotone = 1;
+    if (target <= 0 || target >= 1 || games < 1 || (games + FLIGHT_BLOCK - 1) / FLIGHT_BLOCK > 0x7FFFFFFF) {
+        printf("Error: --calibrate needs a target between 0 and 1 and a positive game count.\n");
+        return 1;
+    }
+
+    memset(&run, 0, sizeof(run));
+    run.config = (GameConfig)DEFAULT_GAME_CONFIG;
+    run.games = games;
+    run.autopilot = lander_autopilot_open(plugin_path);
+    if (!run.autopilot) return 1;
+    run.lanes = batch_lanes_create(threads);
+    run.landed = calloc((size_t)threads, sizeof(uint64_t));
+    if (!run.lanes || !run.landed) goto done;
+    allocated = 1;
+
+    printf("Calibrating touchdown limits for %.1f%% success with %s (%lld games per candidate, %d threads)\n",
+           100 * target, lander_autopilot_name(run.autopilot), games, threads);
+    uint64_t start = now_ns();
+    double lo = 0.25, hi = 4.0;
+    double rate_lo = calibration_rate(&run, lo, threads), rate_hi = calibration_rate(&run, hi, threads);
+    printf("  scale %.4f: %6.2f%%\n  scale %.4f: %6.2f%%\n", lo, 100 * rate_lo, hi, 100 * rate_hi);
+    if (target < rate_lo || target > rate_hi) {
+        printf("Error: %s lands %.2f%%-%.2f%% across the searched range; the target is out of reach.\n",
+               lander_autopilot_name(run.autopilot), 100 * rate_lo, 100 * rate_hi);
+        goto done;
+    }
+
+    double best = lo, best_rate = rate_lo;
+    for (int iteration = 0; iteration < 20 && hi - lo > 1e-4; iteration++) {
+        double mid = (lo + hi) / 2;
+        double rate = calibration_rate(&run, mid, threads);
+        printf("  scale %.4f: %6.2f%%\n", mid, 100 * rate);
+        if (rate < rate_lo || rate > rate_hi) monotone = 0;
+        if (fabs(rate - target) < fabs(best_rate - target)) {
+            best = mid;
+            best_rate = rate;
+        }
+        if (rate < target) {
+            lo = mid;
+            rate_lo = rate;
+        } else {
+            hi = mid;
+            rate_hi = rate;
+        }
+        if (fabs(rate - target) < 0.5 / games) break;
+    }
+
+    GameConfig defaults = DEFAULT_GAME_CONFIG;
+    printf("\nCalibrated in %.1f s: %.2f%% success (target %.2f%%)\n", (now_ns() - start) / 1e9, 100 * best_rate,
+           100 * target);
+    printf("  Safe vertical speed:   %.3f m/s\n", defaults.safe_vertical_speed * best);
+    printf("  Safe horizontal speed: %.3f m/s\n", defaults.safe_horizontal_speed * best);
+    printf("  Terrain penalty:       %.3f\n", defaults.terrain_penalty * best);
+    if (!monotone) {
+        printf("Warning: %s's success rate did not grow with the scale; it reacts to the limits, so the bisection\n"
+               "  may have missed a closer scale.\n", lander_autopilot_name(run.autopilot));
+    }
+    status = 0;
+
+done:
+    if (!allocated) printf("Error: Could not set up the calibration.\n");
+    lander_autopilot_close(run.autopilot);
+    batch_lanes_destroy(run.lanes, threads);
+    free(run.landed);
+    return status;
+}
+
@@ -0,0 +1,34 @@
+// Example autopilot plugin: a branch-free suicide burn with drift correction,
+// written as plain loops over the batch arrays so the compiler can vectorize.
+// Build with:
+//   gcc -O2 -shared -fPIC autopilot_plugin.c -o autopilot_plugin.so -lm
+// and fly it with:
+//   ./moon --autopilot ./autopilot_plugin.so --autopilot-games 10000
+
+#include <math.h>
+#include "lander_env.h"
+
+int lander_plugin_abi(void) {
+    return LANDER_AUTOPILOT_ABI;
+}
+
+const char* lander_plugin_name(void) {
+    return "suicide-burn";
+}
+
+void lander_plugin_decide(const LanderBatchView* states, int n, int* actions) {
+    const double dt = states->time_step;
+    const double net = states->engine_force - states->gravity;
+
+    for (int i = 0; i < n; i++) {
+        double next_vel_v = states->vel_v[i] - states->gravity * dt;
+        double stop_speed = net > 0 ? sqrt(2.0 * net * states->altitude[i]) : 0.0;
+        int touchdown = states->altitude[i] + next_vel_v * dt <= 0;
+        double threshold = fmax(stop_speed * 0.8, touchdown ? 1.0 : 2.5);
+        int burn = -next_vel_v > threshold && states->fuel[i] > 0;
+
+        // Burn against horizontal drift: Y pushes right, Z pushes left
+        int side = states->vel_h[i] < 0 ? LANDER_ACTION_LEFT_BURN : LANDER_ACTION_RIGHT_BURN;
+        actions[i] = burn ? side : LANDER_ACTION_DRIFT;
+    }
+}
@@ -0,0 +1,343 @@
+#ifndef LANDER_H
+#define LANDER_H
+
+// Types and functions shared by the game, the environment library and the
+// offline modes. lander_env.h is the library's public face; this header is
+// internal to the build.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "lander_env.h"
+
+// Game configuration
+typedef struct {
+    double gravity;
+    double engine_force;
+    int initial_fuel;
+    int display_delta_v;
+    // Touchdown is safe when |vel_v| < safe_vertical_speed - penalty and
+    // |vel_h| < safe_horizontal_speed - penalty, penalty = |terrain height| * terrain_penalty
+    double safe_vertical_speed;
+    double safe_horizontal_speed;
+    double terrain_penalty;
+} GameConfig;
+
+// Moon gravity, 3 m/s² thrust, 50 fuel, 2.0/1.5 m/s touchdown limits
+#define DEFAULT_GAME_CONFIG {1.6, 3.0, 50, 0, 2.0, 1.5, 0.2}
+
+// Landing radar data
+typedef struct {
+    int active;
+    int turns_remaining;
+    double terrain_height[21];
+    double safe_landing_x;
+    double safe_landing_score;
+} LandingRadar;
+
+typedef struct {
+    double A, B; // A: horizontal position, B: altitude
+    double vel_h, vel_v;
+    double prev_vel_h, prev_vel_v; // For delta V calculation
+    int C; // Fuel
+    int engines_on;
+    double time_step;
+    LandingRadar radar;
+    double difficulty; // estimate_difficulty at the start of the game
+} GameState;
+
+// Headless game session (no console I/O), driven by the load generator
+typedef struct {
+    GameState state;
+    GameConfig config;
+    int game_over;
+    uint32_t rng;
+    uint32_t seed; // Seed of the current game
+    int turn; // Commands applied in the current game
+    uint64_t digest; // Rolling state digest after the last command
+} Session;
+
+#define FRAME_BUFFER_SIZE 4096 // One rendered status frame
+#define TURN_REJECTED -2 // simulate_turn: burn requested with engines off
+
+// session_command results
+#define SESSION_OK 0
+#define SESSION_REJECTED 1
+#define SESSION_LANDED 2
+#define SESSION_CRASHED 3
+
+// Structure-of-arrays batch of landers, one slot per game, laid out so the
+// per-turn physics loop vectorizes
+typedef struct {
+    int count;
+    double time_step;
+    double* A;
+    double* B;
+    double* vel_h;
+    double* vel_v;
+    int* C;
+    int* engines_on;
+    int* radar_turns;
+    double* safe_landing_x;
+    double (*terrain_height)[21];
+    double* burn_direction; // Per-step scratch: -1 right, +1 left, 0 drift
+    double* moving; // Per-step scratch: 1 when the turn advances time
+    void* memory;
+} LanderBatch;
+
+// Landing solver: breadth-first search over turns for the cheapest safe
+// landing. States are deduplicated on a grid finer than any physics step,
+// so only states equal up to rounding noise merge, and each turn keeps at
+// most `beam` states, ranked by fuel burned plus a suicide-burn estimate of
+// the fuel still needed.
+typedef struct {
+    double A, B, vel_h, vel_v;
+    int C;
+    char first_command;
+} SolverNode;
+
+typedef struct {
+    int beam;
+    int max_turns;
+    SolverNode* layer;
+    SolverNode* next;
+    double* scores;
+    double* scratch_scores;
+    int* table; // Open-addressing dedupe table over next[], -1 = empty
+    int table_mask;
+} SolverWorkspace;
+
+#define SOLVER_DEFAULT_BEAM 2048
+
+typedef struct {
+    int min_fuel; // Burns needed for a safe landing, -1 if none was found
+    char first_command; // 'X', 'Y' or 'Z' (engines assumed on), 0 if none
+    int exhaustive; // No state was dropped by the beam, so min_fuel is exact
+    long nodes;
+} SolverResult;
+
+// --find-seed condition on a start: field (SEED_* index) compared to value
+typedef struct {
+    int field;
+    int op;
+    double value;
+} SeedPredicate;
+
+// Load generator options
+typedef struct {
+    int clients;
+    int threads;
+    double rate; // Commands per second per client, 0 = unthrottled
+    double duration;
+    const char* script; // NULL = autopilot
+    int frames; // Render a status frame per command, as a server would send it
+    int metrics_port; // 0 = no metrics endpoint
+    int telemetry_port; // 0 = no UDP telemetry
+    double preview_fraction; // Share of clients that run a solver what-if preview before every command
+    double cpu_quantum_us; // Deficit round robin quantum per session per round, 0 = no fair scheduling
+    double idle_timeout; // Seconds without a served command before a game is abandoned, 0 = never
+    int churn; // Free each finished session and allocate a new one, as connections come and go
+    int check_allocs; // Fail if worker threads call malloc after warm-up (needs -DLANDER_COUNT_ALLOCS)
+    const char* heatmap; // Output prefix for touchdown heatmaps, NULL = none
+} LoadOptions;
+
+// Quantile sketches and touchdown heatmaps (analysis.c)
+
+#define SKETCH_K 512      // Top level capacity: about 0.3% rank error
+#define SKETCH_LEVELS 40  // Enough for 2^40 items, so memory is fixed
+
+// Lower levels shrink by 2/3 each, so about 3 * SKETCH_K items are live at
+// once, but every level reserves SKETCH_K slots: the top level moves up as
+// the sketch grows. That is 160 KB per sketch, fixed for any stream length.
+
+// KLL sketch: level h holds items of weight 2^h. A full level is sorted and
+// every other item (random parity) is promoted, so a sketch of any number
+// of items stays within this struct. Sketches from different threads merge
+// into one with the same guarantees.
+typedef struct {
+    uint64_t count;
+    double min, max;
+    int height;
+    int size[SKETCH_LEVELS];
+    uint32_t rng;
+    double items[SKETCH_LEVELS][SKETCH_K];
+} QuantileSketch;
+
+// Outcome sketches kept per finished game by the load test and Monte Carlo
+#define LOAD_OUTCOME_IMPACT 0 // Vertical speed at touchdown
+#define LOAD_OUTCOME_FUEL 1
+#define LOAD_OUTCOME_TURNS 2
+#define LOAD_OUTCOME_COUNT 3
+
+#define HEATMAP_X_BINS 200  // A from -200 to +200 m, 2 m per bin
+#define HEATMAP_H_BINS 100  // vel_h from -5 to +5 m/s
+#define HEATMAP_V_BINS 100  // Impact speed |vel_v| from 0 to 10 m/s
+#define HEATMAP_SCALE 4     // Pixels per bin in the images
+
+// One shard per thread, merged for export, so counting needs no atomics.
+// Out-of-range values land in the edge bins.
+typedef struct {
+    uint64_t position[HEATMAP_V_BINS][HEATMAP_X_BINS]; // Impact speed by touchdown A
+    uint64_t position_landed[HEATMAP_V_BINS][HEATMAP_X_BINS];
+    uint64_t velocity[HEATMAP_V_BINS][HEATMAP_H_BINS]; // Impact speed by horizontal speed
+    uint64_t velocity_landed[HEATMAP_V_BINS][HEATMAP_H_BINS];
+} LandingHeatmap;
+
+#define DUAL_WIDTH 8 // Input directions carried per pass in forward-mode derivatives
+
+#define TELEMETRY_BATCH 64 // Datagrams per sendmmsg (and per recvmmsg in the listener)
+
+typedef struct {
+    LanderTelemetryHeader header;
+    LanderTelemetryRecord records[LANDER_TELEMETRY_PER_DATAGRAM];
+} TelemetryDatagram;
+
+// UDP telemetry sender, one per thread (lander_env.c)
+typedef struct TelemetryStream TelemetryStream;
+
+// The turn's physics and the touchdown margins, written once over a number
+// type T and its arithmetic (ADD, SUB, MUL, SCALE by a double, ABS, CONST,
+// VALUE back to double). Instantiated here for double, which is the game
+// itself, and for Dual in lander_core.c's forward-mode derivatives. `up` and
+// `side` scale the burn's vertical and sideways thrust: 1 and +1/-1 for a Y/Z
+// burn, which is exact, so the double instance matches the plain arithmetic
+// bit for bit.
+// A margin above 0 means that speed is within the touchdown limit.
+#define DEFINE_LANDER_PHYSICS(SUFFIX, T, ADD, SUB, MUL, SCALE, ABS, CONST, VALUE)                      \
+    static inline void physics_step_##SUFFIX(T* A, T* B, T* vel_h, T* vel_v, T gravity,                \
+                                             T engine_force, double dt, int burn, T up, T side) {      \
+        *vel_v = SUB(*vel_v, SCALE(gravity, dt));                                                      \
+        if (burn) {                                                                                    \
+            T thrust = SCALE(engine_force, dt);                                                        \
+            *vel_v = ADD(*vel_v, MUL(thrust, up));                                                     \
+            *vel_h = ADD(*vel_h, MUL(SCALE(thrust, 0.3), side));                                       \
+        }                                                                                              \
+        *A = ADD(*A, SCALE(*vel_h, dt));                                                               \
+        *B = ADD(*B, SCALE(*vel_v, dt));                                                               \
+        if (VALUE(*B) < 0) *B = CONST(0);                                                              \
+    }                                                                                                  \
+    static inline void landing_margins_##SUFFIX(T A, T vel_h, T vel_v, const double* terrain_height,   \
+                                                T safe_vertical, T safe_horizontal, T penalty_factor,  \
+                                                T* margin_v, T* margin_h) {                            \
+        T penalty = CONST(0);                                                                          \
+        if (VALUE(A) >= -100 && VALUE(A) <= 100) {                                                     \
+            int index = (int)((VALUE(A) + 100) / 10.0);                                                \
+            if (index < 0) index = 0;                                                                  \
+            if (index > 20) index = 20;                                                                \
+            penalty = SCALE(penalty_factor, fabs(terrain_height[index]));                              \
+        }                                                                                              \
+        *margin_v = SUB(SUB(safe_vertical, penalty), ABS(vel_v));                                      \
+        *margin_h = SUB(SUB(safe_horizontal, penalty), ABS(vel_h));                                    \
+    }
+
+#define REAL_ADD(a, b) ((a) + (b))
+#define REAL_SUB(a, b) ((a) - (b))
+#define REAL_MUL(a, b) ((a) * (b))
+#define REAL_SCALE(a, c) ((a) * (c))
+#define REAL_CONST(c) (c)
+#define REAL_VALUE(a) (a)
+DEFINE_LANDER_PHYSICS(real, double, REAL_ADD, REAL_SUB, REAL_MUL, REAL_SCALE, fabs, REAL_CONST, REAL_VALUE)
+
+static inline uint32_t lander_rand(uint32_t* rng) {
+    // xorshift32: reentrant, so sessions on different threads never share state
+    uint32_t x = *rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *rng = x;
+    return x;
+}
+
+// Seeds the generator and makes a start's first four draws, its position and
+// velocity; returns the generator for the terrain. The seed search filters on
+// these draws before building any terrain, so both go through here.
+static inline uint32_t start_kinematics(uint32_t seed, double* A, double* B, double* vel_h, double* vel_v) {
+    uint32_t rng = seed * 2654435761u + 0x9E3779B9u;
+    if (rng == 0) rng = 1;
+
+    *A = (double)((int)(lander_rand(&rng) % 200) - 100);
+    *B = (double)((int)(lander_rand(&rng) % 500) + 100);
+    *vel_h = (double)((int)(lander_rand(&rng) % 20) - 10) / 2.0;
+    *vel_v = (double)((int)(lander_rand(&rng) % 20) - 15);
+    return rng;
+}
+
+// --- lander_core.c: rules, physics, sessions, solver, parallel helpers ---
+
+void init_game(GameState* state, GameConfig* config);
+void init_game_seeded(GameState* state, GameConfig* config, uint32_t seed);
+double estimate_difficulty(GameState* state, GameConfig* config);
+int simulate_turn(GameState* state, GameConfig* config, char command);
+void update_physics(GameState* state, GameConfig* config, char move_command);
+int check_landing(GameState* state, GameConfig* config);
+void generate_terrain_data(GameState* state, uint32_t* rng);
+double calculate_landing_safety(GameState* state, double x_pos);
+void display_visualizer(FILE* out, GameState* state);
+void display_status(FILE* out, GameState* state, GameConfig* config);
+char autopilot_command(GameState* state, GameConfig* config);
+void init_session(Session* session, GameConfig* config, uint32_t seed);
+void session_start(Session* session, uint32_t seed);
+int session_command(Session* session, char command);
+uint64_t state_digest(GameState* state, uint64_t previous);
+uint64_t config_digest(GameConfig* config);
+uint64_t now_ns(void);
+uint64_t thread_cpu_ns(void);
+int default_thread_count(void);
+void parallel_for(int count, int threads, void (*body)(void* context, int index, int thread), void* context);
+void work_steal_for(int count, int threads, void (*body)(void* context, int index, int thread), void* context);
+int solver_init(SolverWorkspace* workspace, int beam);
+void solver_free(SolverWorkspace* workspace);
+void solve_landing(SolverWorkspace* workspace, GameState* start, GameConfig* config, SolverResult* result);
+void throttle_rollout(const GameState* start, const GameConfig* config, int turns, const double* throttles,
+                      double* out);
+void throttle_jacobian(const GameState* start, const GameConfig* config, int turns, const double* throttles,
+                       double* values, double* jacobian);
+
+// --- lander_env.c: batch engine, observations, telemetry, plugins ---
+
+int batch_init(LanderBatch* batch, int count);
+void batch_free(LanderBatch* batch);
+void batch_load(LanderBatch* batch, int index, GameState* state);
+void batch_step(LanderBatch* batch, GameConfig* config, const int* actions, int* results);
+void batch_encode_observations(LanderBatch* batch, GameConfig* config, int layout, void* out);
+void batch_view(LanderBatch* batch, GameConfig* config, LanderBatchView* view);
+TelemetryStream* telemetry_open(int port, int source);
+void telemetry_flush(TelemetryStream* stream);
+LanderTelemetryRecord* telemetry_next(TelemetryStream* stream, uint64_t now);
+void telemetry_tick(TelemetryStream* stream, uint64_t now);
+uint64_t telemetry_deadline(TelemetryStream* stream);
+void telemetry_totals(TelemetryStream* stream, uint64_t* records, uint64_t* datagrams, uint64_t* syscalls);
+void telemetry_fill_state(LanderTelemetryRecord* record, GameState* state);
+void telemetry_close(TelemetryStream* stream);
+
+// --- analysis.c: offline modes ---
+
+void sketch_init(QuantileSketch* sketch, uint32_t seed);
+void sketch_add(QuantileSketch* sketch, double value);
+void sketch_merge(QuantileSketch* into, const QuantileSketch* from);
+void report_outcomes(const QuantileSketch* outcomes);
+void heatmap_add(LandingHeatmap* heatmap, double A, double vel_h, double vel_v, int landed);
+int heatmap_export_shards(LandingHeatmap** shards, int count, const char* prefix);
+int run_autopilot_games(const char* plugin_path, int games);
+int run_batch_check(int games);
+int run_tournament(const char** plugin_paths, int plugin_count, int seeds, int threads);
+int run_monte_carlo(const char* plugin_path, long long games, int threads, const char* heatmap_prefix);
+int run_success_map(const char* prefix, const char* plugin_path, int use_solver, int seeds, int threads);
+int run_config_sweep(const char* plugin_path, int grid, int samples, int games, int threads);
+int run_calibration(const char* plugin_path, double target, long long games, int threads);
+int run_difficulty_validation(int starts, int threads);
+int parse_seed_predicate(const char* text, SeedPredicate* predicate);
+int run_seed_search(const SeedPredicate* predicates, int predicate_count, int wanted, int threads);
+int run_ad_benchmark(int rollouts);
+int run_trajectory_optimizer(int starts, int threads);
+
+// --- load_test.c: load generator and transport benchmarks ---
+
+int run_load_test(LoadOptions* options);
+int run_telemetry_listen(int port, double duration);
+int run_shm_benchmark(int n_envs, int obs_layout, int steps);
+
+#endif
@@ -0,0 +1,806 @@
+// Game rules and physics, headless sessions and state digests, the landing
+// solver, the parallel helpers and forward-mode derivatives: the pieces the
+// game, the environment library and the offline modes all share.
+
+#include <time.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "lander.h"
+
+int simulate_turn(GameState* state, GameConfig* config, char command) {
+    if (state->C <= 0) {
+        state->engines_on = 0;
+        command = 'X';
+    }
+
+    if ((command == 'Y' || command == 'Z') && !state->engines_on) return TURN_REJECTED;
+
+    update_physics(state, config, command);
+    if (command != 'X') state->C--;
+
+    if (state->radar.active && state->radar.turns_remaining > 0) {
+        state->radar.turns_remaining--;
+        if (state->radar.turns_remaining <= 0) state->radar.active = 0;
+    }
+
+    return check_landing(state, config);
+}
+
+void init_game(GameState* state, GameConfig* config) {
+    init_game_seeded(state, config, (uint32_t)rand());
+}
+
+void init_game_seeded(GameState* state, GameConfig* config, uint32_t seed) {
+    uint32_t rng = start_kinematics(seed, &state->A, &state->B, &state->vel_h, &state->vel_v);
+    state->prev_vel_h = state->vel_h;
+    state->prev_vel_v = state->vel_v;
+    state->C = config->initial_fuel;
+    state->engines_on = 0;
+    state->time_step = 1.0;
+    state->radar.active = 0;
+    state->radar.turns_remaining = 0;
+    generate_terrain_data(state, &rng);
+    state->difficulty = estimate_difficulty(state, config);
+}
+
+// Burns a start needs as a share of the fuel budget, in closed form. Every
+// burn brakes and pushes sideways at once, so the estimate is the larger of
+// a suicide burn (plus two burns of slack for whole turns) and the side
+// thrust to reach safe_landing_x during the fall and stop there. The pad is
+// optional, since any flat enough spot will do, so the second term counts a
+// quarter; --validate-difficulty checks the weights against the solver.
+// Above 1 the start is likely unwinnable.
+double estimate_difficulty(GameState* state, GameConfig* config) {
+    double dt = state->time_step, g = config->gravity, force = config->engine_force;
+    double net = force - g;
+    if (net <= 0 || config->initial_fuel <= 0) return 10.0;
+
+    double energy = state->vel_v * state->vel_v + 2.0 * g * fmax(state->B, 0.0);
+    double vertical = sqrt(energy * net / force) / (net * dt) + 2.0;
+
+    double fall_time = fmax((state->vel_v + sqrt(energy)) / g, dt);
+    double cruise = (state->radar.safe_landing_x - state->A) / fall_time;
+    double side_dv = force * dt * 0.3;
+    double horizontal = (fabs(cruise - state->vel_h) + fabs(cruise)) / side_dv;
+
+    return fmax(vertical, 0.25 * horizontal) / config->initial_fuel;
+}
+
+void generate_terrain_data(GameState* state, uint32_t* rng) {
+    for (int i = 0; i < 21; i++) {
+        double x_pos = -100 + (i * 10);
+        double base_height = 0.0;
+        double variation = sin(x_pos * 0.1) * 5 + cos(x_pos * 0.05) * 3;
+        double hazard = (lander_rand(rng) % 100 < 15) ? ((int)(lander_rand(rng) % 20) - 10) * 0.5 : 0.0;
+        state->radar.terrain_height[i] = base_height + variation + hazard;
+    }
+
+    double best_safety = -1, best_x = 0;
+    for (int i = 1; i < 20; i++) {
+        double x_pos = -100 + (i * 10);
+        double safety = calculate_landing_safety(state, x_pos);
+        if (safety > best_safety) {
+            best_safety = safety;
+            best_x = x_pos;
+        }
+    }
+    state->radar.safe_landing_x = best_x;
+    state->radar.safe_landing_score = best_safety;
+}
+
+double calculate_landing_safety(GameState* state, double x_pos) {
+    int index = (int)((x_pos + 100) / 10);
+    if (index < 0 || index >= 21) return 0;
+    double safety = 100.0;
+    safety -= fabs(state->radar.terrain_height[index]) * 10;
+    if (index > 0 && index < 20) {
+        double slope_left = fabs(state->radar.terrain_height[index] - state->radar.terrain_height[index - 1]);
+        double slope_right = fabs(state->radar.terrain_height[index + 1] - state->radar.terrain_height[index]);
+        safety -= (slope_left + slope_right) * 5;
+    }
+    return fmax(0, safety);
+}
+
+void display_visualizer(FILE* out, GameState* state) {
+    const int VIS_WIDTH = 61;
+    const int VIS_HEIGHT = 16;
+    const double WORLD_X_MIN = -100.0, WORLD_X_MAX = 100.0;
+
+    double world_view_height_m;
+    double world_y_min;
+
+    if (state->B < 60.0) { // Low altitude: "Landing Mode"
+        world_view_height_m = 40.0;
+        world_y_min = -15.0;
+    } else { // High altitude: "Approach Mode"
+        world_view_height_m = 150.0;
+        double world_y_max = state->B + 30.0;
+        world_y_min = world_y_max - world_view_height_m;
+    }
+
+    char canvas[VIS_HEIGHT][VIS_WIDTH + 1];
+    memset(canvas, ' ', sizeof(canvas));
+    for (int i = 0; i < VIS_HEIGHT; i++) canvas[i][VIS_WIDTH] = '\0';
+
+    double prev_terrain_h = 0.0;
+    for (int x = 0; x < VIS_WIDTH; x++) {
+        double world_x = WORLD_X_MIN + (x / (double)(VIS_WIDTH - 1)) * (WORLD_X_MAX - WORLD_X_MIN);
+        double pos_in_array = (world_x - WORLD_X_MIN) / 10.0;
+        int index1 = fmax(0, fmin(20, (int)floor(pos_in_array)));
+        int index2 = fmax(0, fmin(20, (int)ceil(pos_in_array)));
+
+        // Interpolation for nicer visual
+        double terrain_h = (index1 == index2) ? state->radar.terrain_height[index1] : state->radar.terrain_height[index1] + (state->radar.terrain_height[index2] - state->radar.terrain_height[index1]) * (pos_in_array - index1);
+
+        int canvas_y = (VIS_HEIGHT - 1) - (int)round(((terrain_h - world_y_min) / world_view_height_m) * (VIS_HEIGHT - 1));
+
+        if (canvas_y >= 0 && canvas_y < VIS_HEIGHT) {
+            char terrain_char = '_';
+            if (x > 0) {
+                if (terrain_h > prev_terrain_h + 0.5) terrain_char = '/';
+                if (terrain_h < prev_terrain_h - 0.5) terrain_char = '\\';
+            }
+            prev_terrain_h = terrain_h;
+            canvas[canvas_y][x] = terrain_char;
+            for (int fill_y = canvas_y + 1; fill_y < VIS_HEIGHT; fill_y++) canvas[fill_y][x] = '#';
+        }
+    }
+
+    int lander_x = (int)round(((state->A - WORLD_X_MIN) / (WORLD_X_MAX - WORLD_X_MIN)) * (VIS_WIDTH - 1));
+    int lander_y = (VIS_HEIGHT - 1) - (int)round(((state->B - world_y_min) / world_view_height_m) * (VIS_HEIGHT - 1));
+
+    if (lander_y >= 0 && lander_y < VIS_HEIGHT && lander_x >= 0 && lander_x < VIS_WIDTH) {
+        if (canvas[lander_y][lander_x] == ' ') canvas[lander_y][lander_x] = 'A';
+        if (state->engines_on && lander_y < VIS_HEIGHT - 1 && canvas[lander_y + 1][lander_x] == ' ') {
+            canvas[lander_y + 1][lander_x] = '*';
+        }
+    }
+
+    fprintf(out, "\n.---[ RADAR VISUALS ]-----------------------------------------------.\n");
+    for (int i = 0; i < VIS_HEIGHT; i++) {
+        fprintf(out, "| %s | %+.0fm\n", canvas[i], (world_y_min + world_view_height_m) - (i / (double)(VIS_HEIGHT - 1) * world_view_height_m));
+    }
+    fprintf(out, "`------------------------------------------------------------------´\n");
+    fprintf(out, "  %-30s 0m %28s\n", "-100m", "+100m");
+}
+
+void display_status(FILE* out, GameState* state, GameConfig* config) {
+    if (state->radar.active) {
+        display_visualizer(out, state);
+    }
+
+    fprintf(out, "\n--- LANDER STATUS ---\n");
+    fprintf(out, "A (X pos): %8.1f m\n", state->A);
+    fprintf(out, "B (Alt):   %8.1f m\n", state->B);
+
+    if (config->display_delta_v) {
+        double delta_h = state->vel_h - state->prev_vel_h;
+        double delta_v = state->vel_v - state->prev_vel_v;
+        fprintf(out, "ΔV H:      %8.1f m/s\n", delta_h);
+        fprintf(out, "ΔV V:      %8.1f m/s\n", delta_v);
+    } else {
+        fprintf(out, "Vel H:     %8.1f m/s  %s\n", state->vel_h, state->vel_h > 0 ? "->" : "<-");
+        fprintf(out, "Vel V:     %8.1f m/s  %s\n", state->vel_v, state->vel_v < 0 ? "v (Down)" : "^ (Up)");
+    }
+
+    fprintf(out, "C (Fuel):  %8d burns\n", state->C);
+    fprintf(out, "Engines:   %s\n", state->engines_on ? "ON" : "OFF");
+
+    if (state->radar.active) {
+        fprintf(out, "Radar:     ACTIVE (%d turns remaining)\n", state->radar.turns_remaining);
+    } else {
+        fprintf(out, "Radar:     INACTIVE (use 'R' for visuals)\n");
+    }
+    fprintf(out, "---------------------\n");
+}
+
+void update_physics(GameState* state, GameConfig* config, char move_command) {
+    state->prev_vel_h = state->vel_h;
+    state->prev_vel_v = state->vel_v;
+    int burn = state->engines_on && (move_command == 'Y' || move_command == 'Z');
+    physics_step_real(&state->A, &state->B, &state->vel_h, &state->vel_v, config->gravity, config->engine_force,
+                      state->time_step, burn, 1.0, move_command == 'Y' ? 1.0 : -1.0);
+}
+
+int check_landing(GameState* state, GameConfig* config) {
+    if (state->B <= 0) {
+        double margin_v, margin_h;
+        landing_margins_real(state->A, state->vel_h, state->vel_v, state->radar.terrain_height,
+                             config->safe_vertical_speed, config->safe_horizontal_speed, config->terrain_penalty,
+                             &margin_v, &margin_h);
+        return margin_v > 0 && margin_h > 0 ? 1 : -1; // Success or crash
+    }
+    return 0; // Still flying
+}
+
+char autopilot_command(GameState* state, GameConfig* config) {
+    if (state->C <= 0) return 'X';
+    if (!state->engines_on) return 'W';
+
+    double dt = state->time_step;
+    double net = config->engine_force - config->gravity;
+    double next_vel_v = state->vel_v - config->gravity * dt;
+
+    // Fastest descent from which burning every turn still stops at the surface
+    double stop_speed = net > 0 ? sqrt(2.0 * net * state->B) : 0.0;
+    int touchdown = state->B + next_vel_v * dt <= 0;
+    int burn = -next_vel_v > fmax(stop_speed * 0.8, touchdown ? 1.0 : 2.5);
+
+    double turns_left = state->B / fmax(-state->vel_v, 1.0);
+    double target_vel_h = 0.0;
+    if (turns_left > 3) {
+        target_vel_h = (state->radar.safe_landing_x - state->A) / turns_left;
+        target_vel_h = fmax(-3.0, fmin(3.0, target_vel_h));
+    }
+
+    // Spend a spare burn on steering while there is altitude to lose
+    if (!burn && fabs(state->vel_h - target_vel_h) > 1.0 &&
+        next_vel_v + config->engine_force * dt < 0) {
+        burn = 1;
+    }
+
+    if (!burn) return 'X';
+    return state->vel_h < target_vel_h ? 'Y' : 'Z';
+}
+
+void init_session(Session* session, GameConfig* config, uint32_t seed) {
+    memset(session, 0, sizeof(*session));
+    session->config = *config;
+    session->game_over = 1;
+    session->rng = seed ? seed : 1;
+}
+
+void session_start(Session* session, uint32_t seed) {
+    init_game_seeded(&session->state, &session->config, seed);
+    session->game_over = 0;
+    session->seed = seed;
+    session->turn = 0;
+    session->digest = state_digest(&session->state, session->digest ^ seed); // Rolls on across games
+}
+
+// Rolling digest: equal digests at turn N mean (with overwhelming
+// probability) equal states at every turn up to N, so divergence between
+// two runs can be found by binary search over their digest logs
+uint64_t state_digest(GameState* state, uint64_t previous) {
+    uint64_t words[6];
+    memcpy(&words[0], &state->A, sizeof(double));
+    memcpy(&words[1], &state->B, sizeof(double));
+    memcpy(&words[2], &state->vel_h, sizeof(double));
+    memcpy(&words[3], &state->vel_v, sizeof(double));
+    words[4] = (uint64_t)(uint32_t)state->C | (uint64_t)(uint32_t)state->engines_on << 32;
+    words[5] = (uint64_t)(uint32_t)state->radar.active | (uint64_t)(uint32_t)state->radar.turns_remaining << 32;
+
+    uint64_t hash = previous ^ 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 6; i++) {
+        hash ^= words[i];
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 31;
+    }
+    return hash;
+}
+
+// Digest of the rules a game is flown under; display options are left out
+uint64_t config_digest(GameConfig* config) {
+    uint64_t words[6];
+    memcpy(&words[0], &config->gravity, sizeof(double));
+    memcpy(&words[1], &config->engine_force, sizeof(double));
+    words[2] = (uint64_t)(uint32_t)config->initial_fuel;
+    memcpy(&words[3], &config->safe_vertical_speed, sizeof(double));
+    memcpy(&words[4], &config->safe_horizontal_speed, sizeof(double));
+    memcpy(&words[5], &config->terrain_penalty, sizeof(double));
+
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 6; i++) {
+        hash ^= words[i];
+        hash *= 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 31;
+    }
+    return hash;
+}
+
+static int session_apply(Session* session, char command) {
+    GameState* state = &session->state;
+    int landing_result;
+
+    switch (toupper(command)) {
+        case 'V':
+            session_start(session, lander_rand(&session->rng));
+            return SESSION_OK;
+
+        case 'W':
+        case 'S':
+            if (session->game_over) return SESSION_REJECTED;
+            state->engines_on = toupper(command) == 'W';
+            return SESSION_OK;
+
+        case 'R':
+            if (session->game_over || state->C <= 0) return SESSION_REJECTED;
+            state->radar.active = 1;
+            state->radar.turns_remaining = 3;
+            state->C--;
+            return SESSION_OK;
+
+        case 'X':
+        case 'Y':
+        case 'Z':
+            if (session->game_over) return SESSION_REJECTED;
+            landing_result = simulate_turn(state, &session->config, toupper(command));
+            if (landing_result == TURN_REJECTED) return SESSION_REJECTED;
+            if (landing_result == 0) return SESSION_OK;
+            session->game_over = 1;
+            return landing_result == 1 ? SESSION_LANDED : SESSION_CRASHED;
+
+        default:
+            return SESSION_REJECTED;
+    }
+}
+
+int session_command(Session* session, char command) {
+    int in_game = !session->game_over && toupper(command) != 'V';
+    int result = session_apply(session, command);
+    if (in_game) {
+        session->turn++;
+        session->digest = state_digest(&session->state, session->digest);
+    }
+    return result;
+}
+
+// --- Clocks ---
+
+uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// CPU time of the calling thread, which stops while it is preempted
+uint64_t thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// --- Parallel helpers ---
+
+typedef struct {
+    int count;
+    int next; // Claimed with atomic fetch-add, a chunk at a time
+    int chunk;
+    void (*body)(void* context, int index, int thread);
+    void* context;
+} ParallelJob;
+
+typedef struct {
+    ParallelJob* job;
+    int thread;
+} ParallelWorker;
+
+int default_thread_count(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+static void* parallel_worker_main(void* arg) {
+    ParallelWorker* worker = arg;
+    ParallelJob* job = worker->job;
+    for (;;) {
+        int first = __atomic_fetch_add(&job->next, job->chunk, __ATOMIC_RELAXED);
+        if (first >= job->count) break;
+        int last = first + job->chunk < job->count ? first + job->chunk : job->count;
+        for (int i = first; i < last; i++) job->body(job->context, i, worker->thread);
+    }
+    return NULL;
+}
+
+// Runs body(context, i, thread) for i in [0, count) on up to `threads`
+// threads; thread is in [0, threads) and indexes per-thread state
+void parallel_for(int count, int threads, void (*body)(void* context, int index, int thread), void* context) {
+    ParallelJob job = {count, 0, 1, body, context};
+    if (threads < 1) threads = 1;
+    job.chunk = count / (threads * 16) > 1 ? count / (threads * 16) : 1;
+
+    pthread_t* handles = calloc((size_t)threads, sizeof(pthread_t));
+    ParallelWorker* workers = calloc((size_t)threads, sizeof(ParallelWorker));
+    int started = 0;
+    for (int t = 1; handles && workers && t < threads; t++) {
+        workers[t] = (ParallelWorker){&job, t};
+        if (pthread_create(&handles[t], NULL, parallel_worker_main, &workers[t]) == 0) started = t;
+        else break;
+    }
+    ParallelWorker self = {&job, 0};
+    parallel_worker_main(&self);
+    for (int t = 1; t <= started; t++) pthread_join(handles[t], NULL);
+    free(handles);
+    free(workers);
+}
+
+typedef struct {
+    uint64_t* ranges; // Per thread: next task in the low half, end in the high half
+    int threads;
+    void (*body)(void* context, int index, int thread);
+    void* context;
+} StealJob;
+
+typedef struct {
+    StealJob* job;
+    int thread;
+} StealWorker;
+
+static inline uint64_t steal_range(uint32_t next, uint32_t end) {
+    return (uint64_t)end << 32 | next;
+}
+
+// Takes half of the fullest other deque; returns 0 once every deque is empty
+static int steal_work(StealJob* job, int thief) {
+    for (;;) {
+        int victim = -1;
+        uint32_t most = 0;
+        uint64_t seen = 0;
+        for (int t = 0; t < job->threads; t++) {
+            if (t == thief) continue;
+            uint64_t range = __atomic_load_n(&job->ranges[t], __ATOMIC_ACQUIRE);
+            uint32_t next = (uint32_t)range, end = (uint32_t)(range >> 32);
+            if (end > next && end - next > most) {
+                most = end - next;
+                victim = t;
+                seen = range;
+            }
+        }
+        if (victim < 0) return 0;
+
+        uint32_t next = (uint32_t)seen, end = (uint32_t)(seen >> 32);
+        uint32_t split = end - (most + 1) / 2;
+        if (__atomic_compare_exchange_n(&job->ranges[victim], &seen, steal_range(next, split), 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            __atomic_store_n(&job->ranges[thief], steal_range(split, end), __ATOMIC_RELEASE);
+            return 1;
+        }
+    }
+}
+
+static void* steal_worker_main(void* arg) {
+    StealWorker* worker = arg;
+    StealJob* job = worker->job;
+    uint64_t* mine = &job->ranges[worker->thread];
+    for (;;) {
+        // Owner pops from the front; thieves only ever move the end
+        uint64_t range = __atomic_load_n(mine, __ATOMIC_ACQUIRE);
+        uint32_t next = (uint32_t)range, end = (uint32_t)(range >> 32);
+        if (next >= end) {
+            if (!steal_work(job, worker->thread)) break;
+            continue;
+        }
+        if (!__atomic_compare_exchange_n(mine, &range, steal_range(next + 1, end), 0,
+                                         __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        job->body(job->context, (int)next, worker->thread);
+    }
+    return NULL;
+}
+
+// Same contract as parallel_for, but each thread starts with its own
+// contiguous slice and idle threads steal half of the largest remaining
+// slice, so uneven task costs balance without a shared counter
+void work_steal_for(int count, int threads, void (*body)(void* context, int index, int thread), void* context) {
+    if (threads < 1) threads = 1;
+    StealJob job = {calloc((size_t)threads, sizeof(uint64_t)), threads, body, context};
+    pthread_t* handles = calloc((size_t)threads, sizeof(pthread_t));
+    StealWorker* workers = calloc((size_t)threads, sizeof(StealWorker));
+    if (!job.ranges || !handles || !workers) {
+        for (int i = 0; i < count; i++) body(context, i, 0);
+        free(job.ranges);
+        free(handles);
+        free(workers);
+        return;
+    }
+
+    for (int t = 0; t < threads; t++) {
+        job.ranges[t] = steal_range((uint32_t)((int64_t)count * t / threads), (uint32_t)((int64_t)count * (t + 1) / threads));
+    }
+    int started = 0;
+    for (int t = 1; t < threads; t++) {
+        workers[t] = (StealWorker){&job, t};
+        if (pthread_create(&handles[t], NULL, steal_worker_main, &workers[t]) == 0) started = t;
+        else break;
+    }
+    StealWorker self = {&job, 0};
+    steal_worker_main(&self); // Also drains the slices of threads that failed to start
+    for (int t = 1; t <= started; t++) pthread_join(handles[t], NULL);
+    free(job.ranges);
+    free(handles);
+    free(workers);
+}
+
+// --- Landing solver ---
+
+int solver_init(SolverWorkspace* workspace, int beam) {
+    memset(workspace, 0, sizeof(*workspace));
+    int table_size = 1;
+    while (table_size < beam * 6) table_size <<= 1;
+
+    workspace->beam = beam;
+    workspace->max_turns = 400;
+    workspace->layer = malloc((size_t)beam * 3 * sizeof(SolverNode));
+    workspace->next = malloc((size_t)beam * 3 * sizeof(SolverNode));
+    workspace->scores = malloc((size_t)beam * 3 * sizeof(double));
+    workspace->scratch_scores = malloc((size_t)beam * 3 * sizeof(double));
+    workspace->table = malloc((size_t)table_size * sizeof(int));
+    workspace->table_mask = table_size - 1;
+    if (!workspace->layer || !workspace->next || !workspace->scores || !workspace->scratch_scores ||
+        !workspace->table) {
+        solver_free(workspace);
+        return -1;
+    }
+    return 0;
+}
+
+void solver_free(SolverWorkspace* workspace) {
+    free(workspace->layer);
+    free(workspace->next);
+    free(workspace->scores);
+    free(workspace->scratch_scores);
+    free(workspace->table);
+    memset(workspace, 0, sizeof(*workspace));
+}
+
+// Burning every remaining turn is the hardest possible braking; if even that
+// reaches the ground too fast (or runs out of fuel first), the state is lost
+static int solver_doomed(SolverNode* node, GameConfig* config, double dt) {
+    double net = (config->engine_force - config->gravity) * dt;
+    double vel_v = node->vel_v, B = node->B;
+    int fuel = node->C;
+
+    if (vel_v >= -config->safe_vertical_speed) return 0;
+    if (net <= 0) return 1;
+    while (vel_v < -config->safe_vertical_speed) {
+        if (fuel-- <= 0) return 1;
+        vel_v += net;
+        B += vel_v * dt;
+        if (B <= 0) return 1;
+    }
+    return 0;
+}
+
+// Burns a continuous suicide burn would still need: fall freely, then brake
+// at full thrust so the speed reaches zero at the surface
+static double solver_fuel_estimate(SolverNode* node, GameConfig* config, double dt) {
+    double net = config->engine_force - config->gravity;
+    if (net <= 0) return 1e9;
+    double energy = node->vel_v * node->vel_v + 2.0 * config->gravity * fmax(node->B, 0.0);
+    return sqrt(energy * net / config->engine_force) / (net * dt);
+}
+
+// k-th smallest value (0-based); reorders values
+static double select_kth(double* values, int count, int k) {
+    int left = 0, right = count - 1;
+    while (left < right) {
+        double pivot = values[(left + right) / 2];
+        int i = left, j = right;
+        while (i <= j) {
+            while (values[i] < pivot) i++;
+            while (values[j] > pivot) j--;
+            if (i <= j) {
+                double swap = values[i];
+                values[i++] = values[j];
+                values[j--] = swap;
+            }
+        }
+        if (k <= j) right = j;
+        else if (k >= i) left = i;
+        else break;
+    }
+    return values[k];
+}
+
+// States reached by different burn orders can differ by a few ulps, so
+// coordinates are compared on a 1e-6 grid: far below any step the physics
+// takes, far above the rounding noise
+#define SOLVER_KEY_SCALE 1e6
+
+static uint64_t solver_key(SolverNode* node) {
+    uint64_t key = (uint64_t)llround(node->A * SOLVER_KEY_SCALE) * 0x9E3779B97F4A7C15ull;
+    key ^= (uint64_t)llround(node->B * SOLVER_KEY_SCALE) * 0xC2B2AE3D27D4EB4Full;
+    key ^= (uint64_t)llround(node->vel_h * SOLVER_KEY_SCALE) * 0x165667B19E3779F9ull;
+    key ^= (uint64_t)llround(node->vel_v * SOLVER_KEY_SCALE) * 0x27D4EB2F165667C5ull;
+    return key ^ (key >> 29);
+}
+
+static int solver_same(SolverNode* a, SolverNode* b) {
+    return llround(a->A * SOLVER_KEY_SCALE) == llround(b->A * SOLVER_KEY_SCALE) &&
+           llround(a->B * SOLVER_KEY_SCALE) == llround(b->B * SOLVER_KEY_SCALE) &&
+           llround(a->vel_h * SOLVER_KEY_SCALE) == llround(b->vel_h * SOLVER_KEY_SCALE) &&
+           llround(a->vel_v * SOLVER_KEY_SCALE) == llround(b->vel_v * SOLVER_KEY_SCALE);
+}
+
+void solve_landing(SolverWorkspace* workspace, GameState* start, GameConfig* config, SolverResult* result) {
+    static const char COMMANDS[3] = {'X', 'Y', 'Z'};
+    GameState scratch = *start;
+    int layer_size = 1, initial_fuel = start->C;
+
+    result->min_fuel = -1;
+    result->first_command = 0;
+    result->exhaustive = 1;
+    result->nodes = 0;
+
+    workspace->layer[0] = (SolverNode){start->A, start->B, start->vel_h, start->vel_v, start->C, 0};
+
+    for (int turn = 0; turn < workspace->max_turns && layer_size > 0; turn++) {
+        int next_size = 0;
+        memset(workspace->table, -1, (size_t)(workspace->table_mask + 1) * sizeof(int));
+
+        for (int n = 0; n < layer_size; n++) {
+            SolverNode* node = &workspace->layer[n];
+            for (int c = 0; c < 3; c++) {
+                if (c > 0 && node->C <= 0) break;
+                int fuel_used = initial_fuel - node->C + (c > 0);
+                if (result->min_fuel >= 0 && fuel_used >= result->min_fuel) continue;
+
+                scratch.A = node->A;
+                scratch.B = node->B;
+                scratch.vel_h = node->vel_h;
+                scratch.vel_v = node->vel_v;
+                scratch.C = node->C;
+                scratch.engines_on = 1;
+                update_physics(&scratch, config, COMMANDS[c]);
+                if (c > 0) scratch.C--;
+                result->nodes++;
+
+                SolverNode child = {scratch.A, scratch.B, scratch.vel_h, scratch.vel_v, scratch.C,
+                                    node->first_command ? node->first_command : COMMANDS[c]};
+                int landing = check_landing(&scratch, config);
+                if (landing == 1) {
+                    result->min_fuel = fuel_used;
+                    result->first_command = child.first_command;
+                    continue;
+                }
+                if (landing != 0 || solver_doomed(&child, config, scratch.time_step)) continue;
+
+                // Dedupe: equal states keep the cheaper path
+                uint64_t key = solver_key(&child);
+                int slot = (int)(key & (uint64_t)workspace->table_mask);
+                while (workspace->table[slot] >= 0 && !solver_same(&workspace->next[workspace->table[slot]], &child)) {
+                    slot = (slot + 1) & workspace->table_mask;
+                }
+                if (workspace->table[slot] >= 0) {
+                    SolverNode* existing = &workspace->next[workspace->table[slot]];
+                    if (child.C > existing->C) *existing = child;
+                    continue;
+                }
+                workspace->table[slot] = next_size;
+                workspace->next[next_size++] = child;
+            }
+        }
+
+        // Beam: keep the states with the lowest estimated total fuel
+        if (next_size > workspace->beam) {
+            for (int n = 0; n < next_size; n++) {
+                SolverNode* node = &workspace->next[n];
+                workspace->scores[n] = (initial_fuel - node->C) + solver_fuel_estimate(node, config, scratch.time_step);
+                workspace->scratch_scores[n] = workspace->scores[n];
+            }
+            double threshold = select_kth(workspace->scratch_scores, next_size, workspace->beam - 1);
+            int below = 0, size = 0;
+            for (int n = 0; n < next_size; n++) below += workspace->scores[n] < threshold;
+            int room = workspace->beam - below;
+            for (int n = 0; n < next_size; n++) {
+                double score = workspace->scores[n];
+                if (score < threshold || (score == threshold && room-- > 0)) workspace->next[size++] = workspace->next[n];
+            }
+            next_size = size;
+            result->exhaustive = 0;
+        }
+
+        SolverNode* swap = workspace->layer;
+        workspace->layer = workspace->next;
+        workspace->next = swap;
+        layer_size = next_size;
+    }
+}
+
+// --- Forward-mode derivatives ---
+
+typedef struct {
+    double value;
+    double d[DUAL_WIDTH]; // Derivatives along DUAL_WIDTH inputs
+} Dual;
+
+static inline Dual dual_const(double c) {
+    Dual r = {c, {0}};
+    return r;
+}
+
+static inline Dual dual_add(Dual a, Dual b) {
+    Dual r = {a.value + b.value, {0}};
+    for (int k = 0; k < DUAL_WIDTH; k++) r.d[k] = a.d[k] + b.d[k];
+    return r;
+}
+
+static inline Dual dual_sub(Dual a, Dual b) {
+    Dual r = {a.value - b.value, {0}};
+    for (int k = 0; k < DUAL_WIDTH; k++) r.d[k] = a.d[k] - b.d[k];
+    return r;
+}
+
+static inline Dual dual_mul(Dual a, Dual b) {
+    Dual r = {a.value * b.value, {0}};
+    for (int k = 0; k < DUAL_WIDTH; k++) r.d[k] = a.d[k] * b.value + a.value * b.d[k];
+    return r;
+}
+
+static inline Dual dual_scale(Dual a, double c) {
+    Dual r = {a.value * c, {0}};
+    for (int k = 0; k < DUAL_WIDTH; k++) r.d[k] = a.d[k] * c;
+    return r;
+}
+
+static inline Dual dual_abs(Dual a) {
+    return a.value < 0 ? dual_scale(a, -1.0) : a;
+}
+
+#define DUAL_VALUE(a) ((a).value)
+DEFINE_LANDER_PHYSICS(dual, Dual, dual_add, dual_sub, dual_mul, dual_scale, dual_abs, dual_const, DUAL_VALUE)
+
+// Input `index` of a rollout; the pass starting at input `first` tracks
+// derivatives along inputs first .. first + DUAL_WIDTH - 1
+static inline Dual dual_input(double value, int index, int first) {
+    Dual r = dual_const(value);
+    if (index >= first && index < first + DUAL_WIDTH) r.d[index - first] = 1.0;
+    return r;
+}
+
+#define REAL_INPUT(value, index, first) (value)
+
+// Fixed-horizon rollout under continuous throttles: turn t burns
+// throttles[2t] of a Y burn and throttles[2t + 1] of a Z burn (0 to 1 each,
+// so (1, 0) is exactly a Y). Inputs are numbered u_y[0], u_z[0], u_y[1], ...,
+// gravity, engine_force. Fuel is not limited; the state freezes at touchdown.
+// out: final A, B, vel_h, vel_v, then the vertical and horizontal margins.
+#define DEFINE_THROTTLE_ROLLOUT(SUFFIX, T, ADD, SUB, INPUT, VALUE)                                      \
+    static void throttle_rollout_##SUFFIX(const GameState* start, const GameConfig* config, int turns,  \
+                                          const double* throttles, int first, T* out) {                \
+        (void)first; /* Only dual inputs track directions */                                           \
+        T A = INPUT(start->A, -1, first), B = INPUT(start->B, -1, first);                              \
+        T vel_h = INPUT(start->vel_h, -1, first), vel_v = INPUT(start->vel_v, -1, first);              \
+        T gravity = INPUT(config->gravity, 2 * turns, first);                                          \
+        T engine_force = INPUT(config->engine_force, 2 * turns + 1, first);                            \
+        for (int t = 0; t < turns && VALUE(B) > 0; t++) {                                              \
+            T u_y = INPUT(throttles[2 * t], 2 * t, first);                                             \
+            T u_z = INPUT(throttles[2 * t + 1], 2 * t + 1, first);                                     \
+            physics_step_##SUFFIX(&A, &B, &vel_h, &vel_v, gravity, engine_force, start->time_step, 1,  \
+                                  ADD(u_y, u_z), SUB(u_y, u_z));                                       \
+        }                                                                                              \
+        out[0] = A;                                                                                    \
+        out[1] = B;                                                                                    \
+        out[2] = vel_h;                                                                                \
+        out[3] = vel_v;                                                                                \
+        landing_margins_##SUFFIX(A, vel_h, vel_v, start->radar.terrain_height,                         \
+                                 INPUT(config->safe_vertical_speed, -1, first),                        \
+                                 INPUT(config->safe_horizontal_speed, -1, first),                      \
+                                 INPUT(config->terrain_penalty, -1, first), &out[4], &out[5]);         \
+    }
+
+DEFINE_THROTTLE_ROLLOUT(real, double, REAL_ADD, REAL_SUB, REAL_INPUT, REAL_VALUE)
+DEFINE_THROTTLE_ROLLOUT(dual, Dual, dual_add, dual_sub, dual_input, DUAL_VALUE)
+
+// Plain-double rollout, for callers outside this file
+void throttle_rollout(const GameState* start, const GameConfig* config, int turns, const double* throttles,
+                      double* out) {
+    throttle_rollout_real(start, config, turns, throttles, 0, out);
+}
+
+// Full Jacobian in ceil((2 * turns + 2) / DUAL_WIDTH) forward passes
+void throttle_jacobian(const GameState* start, const GameConfig* config, int turns, const double* throttles,
+                              double* values, double* jacobian) {
+    int inputs = 2 * turns + 2;
+    Dual out[LANDER_ROLLOUT_OUTPUTS];
+    for (int first = 0; first < inputs; first += DUAL_WIDTH) {
+        throttle_rollout_dual(start, config, turns, throttles, first, out);
+        for (int o = 0; o < LANDER_ROLLOUT_OUTPUTS; o++) {
+            if (first == 0 && values) values[o] = out[o].value;
+            for (int k = 0; k < DUAL_WIDTH && first + k < inputs; k++) jacobian[o * inputs + first + k] = out[o].d[k];
+        }
+    }
+}
+
@@ -0,0 +1,930 @@
+// The library behind lander_env.h: the structure-of-arrays batch engine,
+// observation encodings, the vectorized environment, autopilot plugins, the
+// shared-memory transport and the curriculum sampler. Built together with
+// lander_core.c into liblander.so, and linked into the game.
+
+#define _GNU_SOURCE // sendmmsg
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <errno.h>
+#include <dlfcn.h>
+#include "lander.h"
+
+// --- UDP telemetry ---
+
+#define TELEMETRY_FLUSH_NS 1000000ull
+
+// One per sending thread; never shared
+struct TelemetryStream {
+    int fd;
+    struct sockaddr_in address;
+    uint16_t source;
+    uint64_t sequence;
+    int count; // Records buffered across all datagrams
+    uint64_t due_ns; // Flush deadline for the oldest buffered record
+    uint64_t records, datagrams, syscalls;
+    TelemetryDatagram datagram[TELEMETRY_BATCH];
+    struct iovec iov[TELEMETRY_BATCH];
+    struct mmsghdr messages[TELEMETRY_BATCH];
+};
+
+TelemetryStream* telemetry_open(int port, int source) {
+    TelemetryStream* stream = calloc(1, sizeof(TelemetryStream));
+    if (!stream) return NULL;
+    stream->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (stream->fd < 0) {
+        free(stream);
+        return NULL;
+    }
+    stream->address.sin_family = AF_INET;
+    stream->address.sin_port = htons((uint16_t)port);
+    stream->address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    stream->source = (uint16_t)source;
+
+    for (int d = 0; d < TELEMETRY_BATCH; d++) {
+        stream->iov[d].iov_base = &stream->datagram[d];
+        stream->messages[d].msg_hdr.msg_name = &stream->address;
+        stream->messages[d].msg_hdr.msg_namelen = sizeof(stream->address);
+        stream->messages[d].msg_hdr.msg_iov = &stream->iov[d];
+        stream->messages[d].msg_hdr.msg_iovlen = 1;
+    }
+    return stream;
+}
+
+void telemetry_flush(TelemetryStream* stream) {
+    int datagrams = (stream->count + LANDER_TELEMETRY_PER_DATAGRAM - 1) / LANDER_TELEMETRY_PER_DATAGRAM;
+    for (int d = 0; d < datagrams; d++) {
+        int records = d < datagrams - 1 ? LANDER_TELEMETRY_PER_DATAGRAM : stream->count - d * LANDER_TELEMETRY_PER_DATAGRAM;
+        LanderTelemetryHeader* header = &stream->datagram[d].header;
+        header->magic = LANDER_TELEMETRY_MAGIC;
+        header->count = (uint16_t)records;
+        header->source = stream->source;
+        header->sequence = stream->sequence++;
+        stream->iov[d].iov_len = sizeof(LanderTelemetryHeader) + (size_t)records * sizeof(LanderTelemetryRecord);
+    }
+
+    // Telemetry is best effort: a full socket buffer drops the rest of the batch
+    for (int sent = 0; sent < datagrams;) {
+        int n = sendmmsg(stream->fd, stream->messages + sent, (unsigned)(datagrams - sent), MSG_DONTWAIT);
+        stream->syscalls++;
+        if (n <= 0) break;
+        sent += n;
+        stream->datagrams += (uint64_t)n;
+    }
+    stream->records += (uint64_t)stream->count;
+    stream->count = 0;
+}
+
+// Slot for the next record, flushing first if the batch is full
+LanderTelemetryRecord* telemetry_next(TelemetryStream* stream, uint64_t now) {
+    if (stream->count == TELEMETRY_BATCH * LANDER_TELEMETRY_PER_DATAGRAM) telemetry_flush(stream);
+    if (stream->count == 0) stream->due_ns = now + TELEMETRY_FLUSH_NS;
+    int index = stream->count++;
+    LanderTelemetryRecord* record = &stream->datagram[index / LANDER_TELEMETRY_PER_DATAGRAM].records[index % LANDER_TELEMETRY_PER_DATAGRAM];
+    record->reserved = 0;
+    return record;
+}
+
+void telemetry_tick(TelemetryStream* stream, uint64_t now) {
+    if (stream->count > 0 && now >= stream->due_ns) telemetry_flush(stream);
+}
+
+// Flush deadline of the oldest buffered record, 0 when nothing is buffered
+uint64_t telemetry_deadline(TelemetryStream* stream) {
+    return stream->count > 0 ? stream->due_ns : 0;
+}
+
+// Adds the stream's counters to the caller's totals
+void telemetry_totals(TelemetryStream* stream, uint64_t* records, uint64_t* datagrams, uint64_t* syscalls) {
+    *records += stream->records;
+    *datagrams += stream->datagrams;
+    *syscalls += stream->syscalls;
+}
+
+void telemetry_fill_state(LanderTelemetryRecord* record, GameState* state) {
+    record->x = (float)state->A;
+    record->altitude = (float)state->B;
+    record->vel_h = (float)state->vel_h;
+    record->vel_v = (float)state->vel_v;
+    record->fuel = (int16_t)state->C;
+}
+
+void telemetry_close(TelemetryStream* stream) {
+    telemetry_flush(stream);
+    close(stream->fd);
+    free(stream);
+}
+
+// --- Batch engine (structure of arrays) ---
+
+int batch_init(LanderBatch* batch, int count) {
+    // One cache-line aligned block; each array starts on its own cache line
+    size_t doubles = ((size_t)count * sizeof(double) + 63) & ~(size_t)63;
+    size_t ints = ((size_t)count * sizeof(int) + 63) & ~(size_t)63;
+    size_t terrain = ((size_t)count * sizeof(double[21]) + 63) & ~(size_t)63;
+    char* memory = aligned_alloc(64, doubles * 7 + ints * 3 + terrain);
+    if (!memory) return -1;
+    memset(memory, 0, doubles * 7 + ints * 3 + terrain);
+
+    batch->count = count;
+    batch->time_step = 1.0;
+    batch->memory = memory;
+    batch->A = (double*)memory;
+    batch->B = (double*)(memory + doubles);
+    batch->vel_h = (double*)(memory + doubles * 2);
+    batch->vel_v = (double*)(memory + doubles * 3);
+    batch->safe_landing_x = (double*)(memory + doubles * 4);
+    batch->burn_direction = (double*)(memory + doubles * 5);
+    batch->moving = (double*)(memory + doubles * 6);
+    batch->C = (int*)(memory + doubles * 7);
+    batch->engines_on = (int*)(memory + doubles * 7 + ints);
+    batch->radar_turns = (int*)(memory + doubles * 7 + ints * 2);
+    batch->terrain_height = (double(*)[21])(memory + doubles * 7 + ints * 3);
+    return 0;
+}
+
+void batch_free(LanderBatch* batch) {
+    free(batch->memory);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void batch_load(LanderBatch* batch, int index, GameState* state) {
+    batch->A[index] = state->A;
+    batch->B[index] = state->B;
+    batch->vel_h[index] = state->vel_h;
+    batch->vel_v[index] = state->vel_v;
+    batch->C[index] = state->C;
+    batch->engines_on[index] = state->engines_on;
+    batch->radar_turns[index] = state->radar.active ? state->radar.turns_remaining : 0;
+    batch->safe_landing_x[index] = state->radar.safe_landing_x;
+    memcpy(batch->terrain_height[index], state->radar.terrain_height, sizeof(batch->terrain_height[index]));
+}
+
+// Same rules as simulate_turn, except that burns switch the engines on and
+// LANDER_ACTION_RADAR activates the radar without advancing time.
+// results[i] receives check_landing's verdict (0 = still flying).
+void batch_step(LanderBatch* batch, GameConfig* config, const int* actions, int* results) {
+    const int n = batch->count;
+    const double dt = batch->time_step;
+    double* restrict A = batch->A;
+    double* restrict B = batch->B;
+    double* restrict vel_h = batch->vel_h;
+    double* restrict vel_v = batch->vel_v;
+    int* restrict C = batch->C;
+    int* restrict engines_on = batch->engines_on;
+    int* restrict radar_turns = batch->radar_turns;
+    double* restrict burn_direction = batch->burn_direction;
+    double* restrict moving = batch->moving;
+
+    // Control: fuel, engines and radar bookkeeping
+    for (int i = 0; i < n; i++) {
+        int action = actions[i];
+        if (C[i] <= 0) {
+            engines_on[i] = 0;
+            if (action != LANDER_ACTION_RADAR) action = LANDER_ACTION_DRIFT;
+        }
+        if (action == LANDER_ACTION_RADAR) {
+            if (C[i] > 0) {
+                C[i]--;
+                radar_turns[i] = 3;
+            }
+            burn_direction[i] = 0;
+            moving[i] = 0; // Time stands still
+            continue;
+        }
+        if (action != LANDER_ACTION_DRIFT) {
+            engines_on[i] = 1;
+            C[i]--;
+        }
+        if (radar_turns[i] > 0) radar_turns[i]--;
+        burn_direction[i] = action == LANDER_ACTION_LEFT_BURN ? 1.0 : action == LANDER_ACTION_RIGHT_BURN ? -1.0 : 0.0;
+        moving[i] = 1;
+    }
+
+    // Physics and landing check: the same functions update_physics and
+    // check_landing use; radar turns leave the lander where it was
+    for (int i = 0; i < n; i++) {
+        if (moving[i] == 0) {
+            results[i] = 0;
+            continue;
+        }
+        double direction = burn_direction[i];
+        physics_step_real(&A[i], &B[i], &vel_h[i], &vel_v[i], config->gravity, config->engine_force, dt,
+                          direction != 0, 1.0, direction);
+        if (B[i] > 0) {
+            results[i] = 0;
+            continue;
+        }
+        double margin_v, margin_h;
+        landing_margins_real(A[i], vel_h[i], vel_v[i], batch->terrain_height[i], config->safe_vertical_speed,
+                             config->safe_horizontal_speed, config->terrain_penalty, &margin_v, &margin_h);
+        results[i] = margin_v > 0 && margin_h > 0 ? 1 : -1;
+    }
+}
+
+// IEEE 754 binary16 bits, round to nearest even
+static uint16_t float_to_half(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (((bits >> 23) & 0xFF) == 0xFF) return (uint16_t)(sign | 0x7C00u | (mantissa ? 0x200u : 0));
+    if (exponent >= 31) return (uint16_t)(sign | 0x7C00u);
+    if (exponent <= 0) { // Subnormal or zero
+        if (exponent < -10) return (uint16_t)sign;
+        mantissa |= 0x800000u;
+        int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1), halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) half++;
+        return (uint16_t)(sign | half);
+    }
+
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1))) half++; // May carry into the exponent, as it should
+    return (uint16_t)half;
+}
+
+static int8_t float_to_i8(float value) {
+    float scaled = value * 127.0f;
+    scaled = scaled > 127.0f ? 127.0f : scaled < -127.0f ? -127.0f : scaled;
+    return (int8_t)(scaled + (scaled >= 0 ? 0.5f : -0.5f)); // Round half away from zero
+}
+
+size_t lander_obs_row_bytes(int layout) {
+    switch (layout) {
+        case LANDER_OBS_F32: return LANDER_OBS_DIM * sizeof(float);
+        case LANDER_OBS_F16: return LANDER_OBS_DIM * sizeof(uint16_t);
+        case LANDER_OBS_I8: return LANDER_OBS_DIM * sizeof(int8_t);
+        default: return 0;
+    }
+}
+
+// Writes one observation row per lander straight into out (see lander_env.h)
+void batch_encode_observations(LanderBatch* batch, GameConfig* config, int layout, void* out) {
+    unsigned char* rows = out;
+    size_t row_bytes = lander_obs_row_bytes(layout);
+    float fuel_scale = config->initial_fuel > 0 ? 1.0f / (float)config->initial_fuel : 0.0f;
+
+    for (int i = 0; i < batch->count; i++) {
+        float row[LANDER_OBS_DIM] = {0};
+        double A = batch->A[i];
+        row[0] = (float)(A / 200.0);
+        row[1] = (float)(batch->B[i] / 600.0);
+        row[2] = (float)(batch->vel_h[i] / 20.0);
+        row[3] = (float)(batch->vel_v[i] / 20.0);
+        row[4] = (float)batch->C[i] * fuel_scale;
+        row[5] = (float)batch->engines_on[i];
+        row[6] = (float)batch->radar_turns[i] / 3.0f;
+
+        int center = (int)lround((A + 100) / 10.0);
+        for (int k = -2; k <= 2; k++) {
+            int index = center + k;
+            index = index < 0 ? 0 : index > 20 ? 20 : index;
+            row[9 + k] = (float)(batch->terrain_height[i][index] / 10.0);
+        }
+        row[12] = (float)((batch->safe_landing_x[i] - A) / 200.0);
+
+        unsigned char* dest = rows + (size_t)i * row_bytes;
+        if (layout == LANDER_OBS_F32) {
+            memcpy(dest, row, sizeof(row));
+        } else if (layout == LANDER_OBS_F16) {
+            uint16_t* half = (uint16_t*)dest;
+            for (int k = 0; k < LANDER_OBS_DIM; k++) half[k] = float_to_half(row[k]);
+        } else {
+            int8_t* quantized = (int8_t*)dest;
+            for (int k = 0; k < LANDER_OBS_DIM; k++) quantized[k] = float_to_i8(row[k]);
+        }
+    }
+}
+
+// --- Vectorized environment API (lander_env.h) ---
+
+struct LanderVecEnv {
+    LanderBatch batch;
+    GameConfig config;
+    int obs_layout;
+    const LanderCurriculum* curriculum;
+    double curriculum_lo, curriculum_hi;
+    uint32_t* rng;
+    int* results;
+    TelemetryStream* telemetry;
+    uint32_t* turns; // Per environment, only kept while telemetry is on
+};
+
+static void vec_reset_env(LanderVecEnv* env, int index) {
+    GameState state;
+    uint32_t seed = env->curriculum
+        ? lander_curriculum_sample(env->curriculum, env->curriculum_lo, env->curriculum_hi, &env->rng[index])
+        : lander_rand(&env->rng[index]);
+    init_game_seeded(&state, &env->config, seed);
+    batch_load(&env->batch, index, &state);
+    if (env->turns) env->turns[index] = 0;
+}
+
+LanderVecEnv* lander_vec_create(int n_envs, uint32_t seed) {
+    if (n_envs <= 0) return NULL;
+    LanderVecEnv* env = calloc(1, sizeof(LanderVecEnv));
+    if (!env) return NULL;
+
+    env->config = (GameConfig)DEFAULT_GAME_CONFIG;
+    env->rng = calloc((size_t)n_envs, sizeof(uint32_t));
+    env->results = calloc((size_t)n_envs, sizeof(int));
+    if (!env->rng || !env->results || batch_init(&env->batch, n_envs) != 0) {
+        lander_vec_destroy(env);
+        return NULL;
+    }
+
+    for (int i = 0; i < n_envs; i++) {
+        env->rng[i] = seed * 2654435761u + (uint32_t)i * 0x9E3779B9u;
+        if (env->rng[i] == 0) env->rng[i] = 1;
+    }
+    return env;
+}
+
+void lander_vec_destroy(LanderVecEnv* env) {
+    if (!env) return;
+    batch_free(&env->batch);
+    if (env->telemetry) telemetry_close(env->telemetry);
+    free(env->turns);
+    free(env->rng);
+    free(env->results);
+    free(env);
+}
+
+int lander_vec_num_envs(const LanderVecEnv* env) {
+    return env->batch.count;
+}
+
+void lander_vec_set_curriculum(LanderVecEnv* env, const LanderCurriculum* curriculum, double q_lo, double q_hi) {
+    env->curriculum = curriculum;
+    env->curriculum_lo = q_lo;
+    env->curriculum_hi = q_hi;
+}
+
+int lander_vec_set_obs_layout(LanderVecEnv* env, int layout) {
+    if (lander_obs_row_bytes(layout) == 0) return -1;
+    env->obs_layout = layout;
+    return 0;
+}
+
+int lander_vec_set_telemetry(LanderVecEnv* env, int port) {
+    if (env->telemetry) telemetry_close(env->telemetry);
+    free(env->turns);
+    env->telemetry = NULL;
+    env->turns = NULL;
+    if (port <= 0) return 0;
+
+    env->telemetry = telemetry_open(port, 0);
+    env->turns = calloc((size_t)env->batch.count, sizeof(uint32_t));
+    if (!env->telemetry || !env->turns) {
+        lander_vec_set_telemetry(env, 0);
+        return -1;
+    }
+    return 0;
+}
+
+static void vec_send_telemetry(LanderVecEnv* env, const int* actions) {
+    static const char commands[] = "XYZR";
+    LanderBatch* batch = &env->batch;
+    uint64_t now = now_ns();
+
+    for (int i = 0; i < batch->count; i++) {
+        LanderTelemetryRecord* record = telemetry_next(env->telemetry, now);
+        int action = actions[i] >= 0 && actions[i] <= LANDER_ACTION_RADAR ? actions[i] : 0;
+        record->digest = 0;
+        record->session = (uint32_t)i;
+        record->turn = ++env->turns[i];
+        record->x = (float)batch->A[i];
+        record->altitude = (float)batch->B[i];
+        record->vel_h = (float)batch->vel_h[i];
+        record->vel_v = (float)batch->vel_v[i];
+        record->fuel = (int16_t)batch->C[i];
+        record->command = commands[action];
+        record->result = (int8_t)env->results[i];
+    }
+    telemetry_tick(env->telemetry, now);
+}
+
+void lander_vec_reset(LanderVecEnv* env, void* observations) {
+    for (int i = 0; i < env->batch.count; i++) vec_reset_env(env, i);
+    batch_encode_observations(&env->batch, &env->config, env->obs_layout, observations);
+}
+
+void lander_vec_step(LanderVecEnv* env, const int* actions, void* observations,
+                     float* rewards, uint8_t* dones) {
+    batch_step(&env->batch, &env->config, actions, env->results);
+    if (env->telemetry) vec_send_telemetry(env, actions); // Final state, before any auto-reset
+
+    for (int i = 0; i < env->batch.count; i++) {
+        int result = env->results[i];
+        rewards[i] = (float)result;
+        dones[i] = result != 0;
+        if (result != 0) vec_reset_env(env, i);
+    }
+    batch_encode_observations(&env->batch, &env->config, env->obs_layout, observations);
+}
+
+// --- Autopilot plugins (lander_env.h) ---
+
+struct LanderAutopilot {
+    void* handle; // NULL for the built-in autopilot
+    LanderDecideFn decide;
+    char name[64];
+};
+
+// Zero-copy view of a batch for plugins
+void batch_view(LanderBatch* batch, GameConfig* config, LanderBatchView* view) {
+    view->x = batch->A;
+    view->altitude = batch->B;
+    view->vel_h = batch->vel_h;
+    view->vel_v = batch->vel_v;
+    view->fuel = batch->C;
+    view->engines_on = batch->engines_on;
+    view->radar_turns = batch->radar_turns;
+    view->safe_landing_x = batch->safe_landing_x;
+    view->terrain_height = (const double (*)[21])batch->terrain_height;
+    view->gravity = config->gravity;
+    view->engine_force = config->engine_force;
+    view->time_step = batch->time_step;
+    view->initial_fuel = config->initial_fuel;
+    view->safe_vertical_speed = config->safe_vertical_speed;
+    view->safe_horizontal_speed = config->safe_horizontal_speed;
+    view->terrain_penalty = config->terrain_penalty;
+}
+
+// autopilot_command lane by lane, so the built-in bot speaks the plugin interface
+static void builtin_decide(const LanderBatchView* states, int n, int* actions) {
+    GameConfig config = {states->gravity, states->engine_force, states->initial_fuel, 0,
+                         states->safe_vertical_speed, states->safe_horizontal_speed, states->terrain_penalty};
+    GameState state;
+    memset(&state, 0, sizeof(state));
+    state.time_step = states->time_step;
+
+    for (int i = 0; i < n; i++) {
+        state.A = states->x[i];
+        state.B = states->altitude[i];
+        state.vel_h = states->vel_h[i];
+        state.vel_v = states->vel_v[i];
+        state.C = states->fuel[i];
+        state.engines_on = 1; // Batch burns ignite the engines themselves
+        state.radar.active = states->radar_turns[i] > 0;
+        state.radar.turns_remaining = states->radar_turns[i];
+        state.radar.safe_landing_x = states->safe_landing_x[i];
+
+        char command = autopilot_command(&state, &config);
+        actions[i] = command == 'Y' ? LANDER_ACTION_LEFT_BURN
+                   : command == 'Z' ? LANDER_ACTION_RIGHT_BURN
+                   : command == 'R' ? LANDER_ACTION_RADAR : LANDER_ACTION_DRIFT;
+    }
+}
+
+LanderAutopilot* lander_autopilot_open(const char* path) {
+    LanderAutopilot* autopilot = calloc(1, sizeof(LanderAutopilot));
+    if (!autopilot) return NULL;
+    if (!path) {
+        autopilot->decide = builtin_decide;
+        strcpy(autopilot->name, "builtin");
+        return autopilot;
+    }
+
+    autopilot->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!autopilot->handle) {
+        printf("Error: %s\n", dlerror());
+        free(autopilot);
+        return NULL;
+    }
+
+    int (*abi)(void) = (int (*)(void))dlsym(autopilot->handle, "lander_plugin_abi");
+    const char* (*name)(void) = (const char* (*)(void))dlsym(autopilot->handle, "lander_plugin_name");
+    autopilot->decide = (LanderDecideFn)dlsym(autopilot->handle, "lander_plugin_decide");
+    if (!abi || abi() != LANDER_AUTOPILOT_ABI || !autopilot->decide) {
+        printf("Error: %s is not a lander autopilot plugin (ABI %d expected).\n", path, LANDER_AUTOPILOT_ABI);
+        lander_autopilot_close(autopilot);
+        return NULL;
+    }
+
+    const char* base = strrchr(path, '/');
+    snprintf(autopilot->name, sizeof(autopilot->name), "%s", name ? name() : base ? base + 1 : path);
+    return autopilot;
+}
+
+void lander_autopilot_close(LanderAutopilot* autopilot) {
+    if (!autopilot) return;
+    if (autopilot->handle) dlclose(autopilot->handle);
+    free(autopilot);
+}
+
+const char* lander_autopilot_name(const LanderAutopilot* autopilot) {
+    return autopilot->name;
+}
+
+LanderDecideFn lander_autopilot_decide_fn(const LanderAutopilot* autopilot) {
+    return autopilot->decide;
+}
+
+// --- Shared-memory transport ---
+
+#define SHM_MAGIC 0x4C4E4452u // "LNDR"
+#define SHM_SLOTS 1             // The client waits for each response, so one slot each way
+#define SHM_LIVENESS_SPINS 1024 // Yields between checks that the peer is still running
+#define SHM_RESET 1
+#define SHM_STEP 2
+#define SHM_CLOSE 3
+
+// Segment layout: header, request slots (client -> server), response slots
+// (server -> client). Each ring index lives on its own cache line and is
+// written by exactly one side.
+typedef struct {
+    uint32_t magic; // Set last, once the server is ready
+    int n_envs;
+    int obs_layout;
+    size_t request_size;
+    size_t response_size;
+    pid_t server_pid;
+    pid_t client_pid; // 0 until a client connects
+    _Alignas(64) uint64_t request_head;
+    _Alignas(64) uint64_t request_tail;
+    _Alignas(64) uint64_t response_head;
+    _Alignas(64) uint64_t response_tail;
+} ShmHeader;
+
+typedef struct {
+    int type;
+    int actions[];
+} ShmRequest;
+
+// Response slot: type, then observations, rewards and dones, each on its own
+// cache line boundary so the observation rows keep their 64-byte alignment
+typedef struct {
+    int type;
+} ShmResponse;
+
+struct LanderShmClient {
+    ShmHeader* header;
+    size_t size;
+    int holding_response; // A response slot is lent to the caller
+};
+
+static size_t shm_align(size_t size) {
+    return (size + 63) & ~(size_t)63;
+}
+
+static ShmRequest* shm_request_slot(ShmHeader* header, uint64_t index) {
+    return (ShmRequest*)((char*)header + shm_align(sizeof(ShmHeader)) + (index % SHM_SLOTS) * header->request_size);
+}
+
+static ShmResponse* shm_response_slot(ShmHeader* header, uint64_t index) {
+    return (ShmResponse*)((char*)header + shm_align(sizeof(ShmHeader)) + SHM_SLOTS * header->request_size +
+                          (index % SHM_SLOTS) * header->response_size);
+}
+
+static size_t shm_observation_bytes(int n_envs, int obs_layout) {
+    return shm_align((size_t)n_envs * lander_obs_row_bytes(obs_layout));
+}
+
+static void* shm_observations(ShmHeader* header, ShmResponse* response) {
+    (void)header;
+    return (char*)response + 64;
+}
+
+static float* shm_rewards(ShmHeader* header, ShmResponse* response) {
+    return (float*)((char*)response + 64 + shm_observation_bytes(header->n_envs, header->obs_layout));
+}
+
+static uint8_t* shm_dones(ShmHeader* header, ShmResponse* response) {
+    return (uint8_t*)shm_rewards(header, response) + shm_align((size_t)header->n_envs * sizeof(float));
+}
+
+// A peer is gone once its pid is free or a zombie (a forked server its
+// parent hasn't reaped yet)
+static int shm_peer_alive(pid_t pid) {
+    if (pid <= 0) return 1; // Not attached yet
+    if (kill(pid, 0) != 0 && errno == ESRCH) return 0;
+
+    char path[64], line[512];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE* stat_file = fopen(path, "r");
+    if (!stat_file) return 1;
+    char* state = fgets(line, sizeof(line), stat_file) ? strrchr(line, ')') : NULL;
+    fclose(stat_file);
+    return !(state && state[1] == ' ' && state[2] == 'Z');
+}
+
+// Spin briefly, then yield so a client and server sharing a core still
+// progress. Returns -1 if the peer dies while we wait.
+static int shm_wait_while_equal(uint64_t* index, uint64_t value, const pid_t* peer) {
+    for (int spins = 0; __atomic_load_n(index, __ATOMIC_ACQUIRE) == value; spins++) {
+        if (spins <= 1000) continue;
+        sched_yield();
+        if (spins % SHM_LIVENESS_SPINS == 0 && !shm_peer_alive(__atomic_load_n(peer, __ATOMIC_ACQUIRE))) return -1;
+    }
+    return 0;
+}
+
+static int shm_wait_for_slot(uint64_t* tail, uint64_t head, const pid_t* peer) {
+    for (int spins = 0; head - __atomic_load_n(tail, __ATOMIC_ACQUIRE) >= SHM_SLOTS; spins++) {
+        if (spins <= 1000) continue;
+        sched_yield();
+        if (spins % SHM_LIVENESS_SPINS == 0 && !shm_peer_alive(__atomic_load_n(peer, __ATOMIC_ACQUIRE))) return -1;
+    }
+    return 0;
+}
+
+int lander_shm_serve(const char* name, int n_envs, int obs_layout, uint32_t seed, int telemetry_port) {
+    size_t request_size = shm_align(sizeof(ShmRequest) + (size_t)n_envs * sizeof(int));
+    size_t response_size = 64 + shm_observation_bytes(n_envs, obs_layout) +
+                           shm_align((size_t)n_envs * sizeof(float)) + shm_align((size_t)n_envs);
+    size_t size = shm_align(sizeof(ShmHeader)) + SHM_SLOTS * (request_size + response_size);
+
+    LanderVecEnv* env = lander_vec_create(n_envs, seed);
+    if (!env) return -1;
+    if (lander_vec_set_obs_layout(env, obs_layout) != 0 || lander_vec_set_telemetry(env, telemetry_port) != 0) {
+        lander_vec_destroy(env);
+        return -1;
+    }
+
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+        if (fd >= 0) close(fd);
+        lander_vec_destroy(env);
+        return -1;
+    }
+    ShmHeader* header = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED) {
+        shm_unlink(name);
+        lander_vec_destroy(env);
+        return -1;
+    }
+
+    header->n_envs = n_envs;
+    header->obs_layout = obs_layout;
+    header->request_size = request_size;
+    header->response_size = response_size;
+    header->server_pid = getpid();
+    __atomic_store_n(&header->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+
+    int status = 0;
+    for (uint64_t index = 0;; index++) {
+        if (shm_wait_while_equal(&header->request_head, index, &header->client_pid) != 0 ||
+            shm_wait_for_slot(&header->response_tail, index, &header->client_pid) != 0) {
+            status = -1; // The client died without closing
+            break;
+        }
+
+        ShmRequest* request = shm_request_slot(header, index);
+        ShmResponse* response = shm_response_slot(header, index);
+        response->type = request->type;
+
+        // The environment writes straight into the shared response slot
+        if (request->type == SHM_RESET) {
+            lander_vec_reset(env, shm_observations(header, response));
+        } else if (request->type == SHM_STEP) {
+            lander_vec_step(env, request->actions, shm_observations(header, response),
+                            shm_rewards(header, response), shm_dones(header, response));
+        }
+
+        __atomic_store_n(&header->request_tail, index + 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&header->response_head, index + 1, __ATOMIC_RELEASE);
+        if (request->type == SHM_CLOSE) break;
+    }
+
+    munmap(header, size);
+    shm_unlink(name);
+    lander_vec_destroy(env);
+    return status;
+}
+
+LanderShmClient* lander_shm_connect(const char* name) {
+    int fd = -1;
+    struct stat st;
+    for (int attempt = 0; attempt < 5000; attempt++) {
+        fd = shm_open(name, O_RDWR, 0600);
+        if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) break;
+        if (fd >= 0) close(fd);
+        fd = -1;
+        usleep(1000);
+    }
+    if (fd < 0) return NULL;
+
+    ShmHeader* header = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED) return NULL;
+    for (int attempt = 0; __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC; attempt++) {
+        if (attempt > 5000) {
+            munmap(header, (size_t)st.st_size);
+            return NULL;
+        }
+        usleep(1000);
+    }
+
+    LanderShmClient* client = calloc(1, sizeof(LanderShmClient));
+    if (!client) {
+        munmap(header, (size_t)st.st_size);
+        return NULL;
+    }
+    client->header = header;
+    client->size = (size_t)st.st_size;
+    __atomic_store_n(&header->client_pid, getpid(), __ATOMIC_RELEASE);
+    return client;
+}
+
+int lander_shm_num_envs(const LanderShmClient* client) {
+    return client->header->n_envs;
+}
+
+int lander_shm_obs_layout(const LanderShmClient* client) {
+    return client->header->obs_layout;
+}
+
+int* lander_shm_actions(LanderShmClient* client) {
+    return shm_request_slot(client->header, client->header->request_head)->actions;
+}
+
+static ShmResponse* shm_round_trip(LanderShmClient* client, int type) {
+    ShmHeader* header = client->header;
+    uint64_t index = header->request_head;
+
+    if (client->holding_response) {
+        __atomic_store_n(&header->response_tail, index, __ATOMIC_RELEASE);
+        client->holding_response = 0;
+    }
+
+    if (shm_wait_for_slot(&header->request_tail, index, &header->server_pid) != 0) return NULL;
+    shm_request_slot(header, index)->type = type;
+    __atomic_store_n(&header->request_head, index + 1, __ATOMIC_RELEASE);
+
+    if (shm_wait_while_equal(&header->response_head, index, &header->server_pid) != 0) return NULL;
+    client->holding_response = 1;
+    return shm_response_slot(header, index);
+}
+
+int lander_shm_reset(LanderShmClient* client, const void** observations) {
+    ShmResponse* response = shm_round_trip(client, SHM_RESET);
+    if (!response) return -1;
+    *observations = shm_observations(client->header, response);
+    return 0;
+}
+
+int lander_shm_step(LanderShmClient* client, const void** observations,
+                    const float** rewards, const uint8_t** dones) {
+    ShmResponse* response = shm_round_trip(client, SHM_STEP);
+    if (!response) return -1;
+    *observations = shm_observations(client->header, response);
+    *rewards = shm_rewards(client->header, response);
+    *dones = shm_dones(client->header, response);
+    return 0;
+}
+
+void lander_shm_close(LanderShmClient* client) {
+    if (!client) return;
+    shm_round_trip(client, SHM_CLOSE);
+    munmap(client->header, client->size);
+    free(client);
+}
+
+// --- Throttle derivatives (lander_env.h) ---
+
+int lander_throttle_jacobian(uint32_t seed, int turns, const double* throttles, double* values, double* jacobian) {
+    GameConfig config = DEFAULT_GAME_CONFIG;
+    GameState start;
+    if (turns <= 0 || !throttles || !jacobian) return -1;
+    init_game_seeded(&start, &config, seed);
+    throttle_jacobian(&start, &config, turns, throttles, values, jacobian);
+    return 0;
+}
+
+// --- Curriculum sampler (lander_env.h) ---
+
+typedef struct {
+    uint32_t seed;
+    int difficulty; // Solver minimum fuel; initial_fuel + 1 when unsolved
+} CurriculumEntry;
+
+struct LanderCurriculum {
+    int count;
+    CurriculumEntry* entries; // Sorted from easiest to hardest
+};
+
+typedef struct {
+    CurriculumEntry* entries;
+    uint32_t base_seed;
+    GameConfig config;
+    SolverWorkspace* workspaces; // One per thread
+} CurriculumBuild;
+
+static void curriculum_rank_start(void* context, int index, int thread) {
+    CurriculumBuild* build = context;
+    GameState state;
+    SolverResult result;
+
+    uint32_t seed = build->base_seed + (uint32_t)index;
+    init_game_seeded(&state, &build->config, seed);
+    solve_landing(&build->workspaces[thread], &state, &build->config, &result);
+    build->entries[index].seed = seed;
+    build->entries[index].difficulty = result.min_fuel >= 0 ? result.min_fuel : build->config.initial_fuel + 1;
+}
+
+static int curriculum_compare(const void* a, const void* b) {
+    const CurriculumEntry* x = a;
+    const CurriculumEntry* y = b;
+    if (x->difficulty != y->difficulty) return x->difficulty < y->difficulty ? -1 : 1;
+    return x->seed < y->seed ? -1 : x->seed > y->seed;
+}
+
+LanderCurriculum* lander_curriculum_build(int n_starts, uint32_t base_seed, int threads) {
+    if (n_starts <= 0) return NULL;
+    if (threads < 1) threads = default_thread_count();
+
+    LanderCurriculum* curriculum = calloc(1, sizeof(LanderCurriculum));
+    CurriculumBuild build = {NULL, base_seed, DEFAULT_GAME_CONFIG, NULL};
+    build.workspaces = calloc((size_t)threads, sizeof(SolverWorkspace));
+    int ready = curriculum && build.workspaces;
+    if (ready) build.entries = curriculum->entries = calloc((size_t)n_starts, sizeof(CurriculumEntry));
+    ready = ready && curriculum->entries;
+    for (int t = 0; ready && t < threads; t++) ready = solver_init(&build.workspaces[t], SOLVER_DEFAULT_BEAM) == 0;
+
+    if (ready) {
+        curriculum->count = n_starts;
+        parallel_for(n_starts, threads, curriculum_rank_start, &build);
+        qsort(curriculum->entries, (size_t)n_starts, sizeof(CurriculumEntry), curriculum_compare);
+    }
+
+    for (int t = 0; build.workspaces && t < threads; t++) solver_free(&build.workspaces[t]);
+    free(build.workspaces);
+    if (!ready) {
+        lander_curriculum_free(curriculum);
+        return NULL;
+    }
+    return curriculum;
+}
+
+void lander_curriculum_free(LanderCurriculum* curriculum) {
+    if (!curriculum) return;
+    free(curriculum->entries);
+    free(curriculum);
+}
+
+int lander_curriculum_size(const LanderCurriculum* curriculum) {
+    return curriculum->count;
+}
+
+uint32_t lander_curriculum_sample(const LanderCurriculum* curriculum, double q_lo, double q_hi, uint32_t* rng) {
+    int lo = (int)(fmax(0.0, fmin(1.0, q_lo)) * curriculum->count);
+    int hi = (int)ceil(fmax(0.0, fmin(1.0, q_hi)) * curriculum->count);
+    if (lo >= curriculum->count) lo = curriculum->count - 1;
+    if (hi <= lo) hi = lo + 1;
+    return curriculum->entries[lo + (int)(lander_rand(rng) % (uint32_t)(hi - lo))].seed;
+}
+
+int lander_curriculum_save(const LanderCurriculum* curriculum, const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) return -1;
+    fprintf(fp, "moon-lander-curriculum 1 %d\n", curriculum->count);
+    for (int i = 0; i < curriculum->count; i++) {
+        fprintf(fp, "%u %d\n", curriculum->entries[i].seed, curriculum->entries[i].difficulty);
+    }
+    return fclose(fp) == 0 ? 0 : -1;
+}
+
+LanderCurriculum* lander_curriculum_load(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return NULL;
+
+    int count = 0;
+    LanderCurriculum* curriculum = NULL;
+    if (fscanf(fp, "moon-lander-curriculum 1 %d", &count) == 1 && count > 0) {
+        curriculum = calloc(1, sizeof(LanderCurriculum));
+        if (curriculum) curriculum->entries = calloc((size_t)count, sizeof(CurriculumEntry));
+        if (curriculum && curriculum->entries) {
+            curriculum->count = count;
+            for (int i = 0; i < count; i++) {
+                if (fscanf(fp, "%u %d", &curriculum->entries[i].seed, &curriculum->entries[i].difficulty) != 2) {
+                    lander_curriculum_free(curriculum);
+                    curriculum = NULL;
+                    break;
+                }
+            }
+        } else {
+            lander_curriculum_free(curriculum);
+            curriculum = NULL;
+        }
+    }
+    fclose(fp);
+    return curriculum;
+}
+
@@ -0,0 +1,174 @@
+#ifndef LANDER_ENV_H
+#define LANDER_ENV_H
+
+// Vectorized moon lander environment for reinforcement learning.
+// Build the library with:
+//   gcc -O2 -shared -fPIC lander_core.c lander_env.c -o liblander.so -lm -pthread -ldl
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Actions, one per environment per step. Burns switch the main engines on.
+#define LANDER_ACTION_DRIFT 0      // X
+#define LANDER_ACTION_LEFT_BURN 1  // Y
+#define LANDER_ACTION_RIGHT_BURN 2 // Z
+#define LANDER_ACTION_RADAR 3      // R: costs 1 fuel, does not advance time
+
+// Fixed observation layout, one row per environment, values normalized to
+// roughly [-1, 1]:
+//   0 A / 200             1 B / 600             2 vel_h / 20
+//   3 vel_v / 20          4 fuel / initial_fuel 5 engines_on
+//   6 radar turns_remaining / 3
+//   7..11 terrain_height / 10 at grid points -2..+2 around A
+//   12 (safe_landing_x - A) / 200
+//   13..15 zero padding
+#define LANDER_OBS_DIM 16
+
+// Row encodings. With a 64-byte aligned observation buffer a float32 row is
+// exactly one cache line, float16 half of one, int8 a quarter; any alignment
+// works, just with rows straddling cache lines.
+#define LANDER_OBS_F32 0
+#define LANDER_OBS_F16 1 // IEEE half precision bits
+#define LANDER_OBS_I8 2  // round(value * 127), saturated
+
+size_t lander_obs_row_bytes(int layout);
+
+typedef struct LanderVecEnv LanderVecEnv;
+
+// Allocates everything up front; step and reset never touch the heap.
+LanderVecEnv* lander_vec_create(int n_envs, uint32_t seed);
+void lander_vec_destroy(LanderVecEnv* env);
+int lander_vec_num_envs(const LanderVecEnv* env);
+int lander_vec_set_obs_layout(LanderVecEnv* env, int layout); // Default LANDER_OBS_F32
+
+// observations: n_envs * lander_obs_row_bytes(layout) bytes, ideally 64-byte aligned
+void lander_vec_reset(LanderVecEnv* env, void* observations);
+
+// Advances every environment by one action. Finished environments are
+// reset immediately: their done flag is set, their reward is +1 (landed)
+// or -1 (crashed) and their observation is the first one of the new game.
+void lander_vec_step(LanderVecEnv* env, const int* actions, void* observations,
+                     float* rewards, uint8_t* dones);
+
+// Curriculum sampler: starts (init_game seeds, which fix both the initial
+// state and the terrain) ranked once by the solver's minimum fuel, so any
+// difficulty quantile can be sampled in O(1). Unsolvable starts rank last.
+typedef struct LanderCurriculum LanderCurriculum;
+
+LanderCurriculum* lander_curriculum_build(int n_starts, uint32_t base_seed, int threads);
+LanderCurriculum* lander_curriculum_load(const char* path);
+int lander_curriculum_save(const LanderCurriculum* curriculum, const char* path);
+void lander_curriculum_free(LanderCurriculum* curriculum);
+int lander_curriculum_size(const LanderCurriculum* curriculum);
+
+// A seed whose difficulty rank lies in [q_lo, q_hi) (quantiles in 0..1)
+uint32_t lander_curriculum_sample(const LanderCurriculum* curriculum, double q_lo, double q_hi, uint32_t* rng);
+
+// Auto-resets draw their starts from the curriculum; NULL restores uniform starts
+void lander_vec_set_curriculum(LanderVecEnv* env, const LanderCurriculum* curriculum, double q_lo, double q_hi);
+
+// Telemetry: one record per environment per step, streamed to UDP port
+// 127.0.0.1:port. Records are packed LANDER_TELEMETRY_PER_DATAGRAM to a
+// datagram behind a LanderTelemetryHeader and sent in batches, so the cost
+// is a few syscalls per millisecond. Buffered records are flushed at least
+// every millisecond of stepping. Returns -1 if the socket can't be opened.
+#define LANDER_TELEMETRY_MAGIC 0x544C444Eu // "NDLT" on the wire, little-endian
+#define LANDER_TELEMETRY_PER_DATAGRAM 32
+
+typedef struct {
+    uint32_t magic;
+    uint16_t count;  // Records that follow
+    uint16_t source; // Sender (load test worker or vec env) within the process
+    uint64_t sequence; // Per source; gaps are lost datagrams
+} LanderTelemetryHeader;
+
+typedef struct {
+    uint64_t digest; // Rolling state digest, 0 where the sender doesn't keep one
+    uint32_t session; // Client or environment index
+    uint32_t turn;    // Commands applied in the current game
+    float x, altitude, vel_h, vel_v;
+    int16_t fuel;
+    char command;  // W/S/R/X/Y/Z/V
+    int8_t result; // 1 landed, -1 crashed, 0 flying, 2 rejected
+    uint32_t reserved;
+} LanderTelemetryRecord;
+
+int lander_vec_set_telemetry(LanderVecEnv* env, int port); // 0 turns it off
+
+// Shared-memory transport: the environment runs in a server process and a
+// trainer steps it through a lock-free request slot and response slot in a
+// POSIX shared memory segment (name like "/lander").
+// telemetry_port: see lander_vec_set_telemetry, 0 = off. Returns 0 when the
+// client closes, -1 if it exits without closing.
+int lander_shm_serve(const char* name, int n_envs, int obs_layout, uint32_t seed, int telemetry_port);
+
+typedef struct LanderShmClient LanderShmClient;
+
+LanderShmClient* lander_shm_connect(const char* name); // Waits for the server to come up
+void lander_shm_close(LanderShmClient* client);
+int lander_shm_num_envs(const LanderShmClient* client);
+int lander_shm_obs_layout(const LanderShmClient* client);
+
+// Zero copy: fill the action array in place, then step. The returned
+// pointers refer to shared memory and stay valid until the next call.
+// Reset and step return -1 if the server process has exited.
+int* lander_shm_actions(LanderShmClient* client);
+int lander_shm_reset(LanderShmClient* client, const void** observations);
+int lander_shm_step(LanderShmClient* client, const void** observations,
+                    const float** rewards, const uint8_t** dones);
+
+// Autopilot plugins: shared objects that decide for a whole batch of
+// landers per call, reading the engine's structure-of-arrays state in place.
+// A plugin exports
+//   int lander_plugin_abi(void);           // returns LANDER_AUTOPILOT_ABI
+//   const char* lander_plugin_name(void);  // optional
+//   void lander_plugin_decide(const LanderBatchView* states, int n, int* actions);
+// and writes one LANDER_ACTION_* per lander. The first burn ignites the engines.
+// Tournaments call decide from several threads at once, on different batches.
+#define LANDER_AUTOPILOT_ABI 1
+
+typedef struct {
+    const double* x;
+    const double* altitude;
+    const double* vel_h;
+    const double* vel_v;
+    const int* fuel;
+    const int* engines_on;
+    const int* radar_turns;     // 0 when the radar is off
+    const double* safe_landing_x;
+    const double (*terrain_height)[21]; // Heights at x = -100, -90, ..., +100
+    double gravity, engine_force, time_step;
+    int initial_fuel;
+    // Touchdown limits, appended so older plugins still read the fields above:
+    // safe when |vel| < limit - |terrain height| * terrain_penalty
+    double safe_vertical_speed, safe_horizontal_speed, terrain_penalty;
+} LanderBatchView;
+
+typedef void (*LanderDecideFn)(const LanderBatchView* states, int n, int* actions);
+
+typedef struct LanderAutopilot LanderAutopilot;
+
+LanderAutopilot* lander_autopilot_open(const char* path); // NULL path: the built-in autopilot
+void lander_autopilot_close(LanderAutopilot* autopilot);
+const char* lander_autopilot_name(const LanderAutopilot* autopilot);
+LanderDecideFn lander_autopilot_decide_fn(const LanderAutopilot* autopilot);
+
+// Forward-mode derivatives of a continuous-throttle rollout from seed's start
+// (default config). throttles[2t], throttles[2t + 1] in [0, 1] scale turn t's
+// Y and Z burn; fuel is not limited and the state freezes at touchdown.
+// values receives the LANDER_ROLLOUT_OUTPUTS final values (A, B, vel_h, vel_v,
+// vertical and horizontal touchdown margins; > 0 is within the limit) and may
+// be NULL. jacobian is row-major [LANDER_ROLLOUT_OUTPUTS][2 * turns + 2],
+// columns u_y[0], u_z[0], ..., u_z[turns - 1], gravity, engine_force.
+#define LANDER_ROLLOUT_OUTPUTS 6
+int lander_throttle_jacobian(uint32_t seed, int turns, const double* throttles, double* values, double* jacobian);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
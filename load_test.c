@@ -0,0 +1,1087 @@
+// Load testing: the multi-client load generator with its timing wheel,
+// session slab and metrics endpoint, the UDP telemetry listener and the
+// shared-memory transport benchmark.
+
+#define _GNU_SOURCE // recvmmsg
+#include <time.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <poll.h>
+#include <errno.h>
+#include "lander.h"
+
+// --- UDP telemetry listener ---
+
+// Minimal live dashboard: per-second record, datagram and loss counts
+int run_telemetry_listen(int port, double duration) {
+    struct sockaddr_in address;
+    static TelemetryDatagram datagrams[TELEMETRY_BATCH];
+    struct iovec iov[TELEMETRY_BATCH];
+    struct mmsghdr messages[TELEMETRY_BATCH];
+    static uint64_t expected[65536]; // Next sequence per source, plus one
+    uint64_t records = 0, received = 0, lost = 0, landed = 0, crashed = 0;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int buffer = 8 << 20;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        printf("Error: Could not listen for telemetry on port %d.\n", port);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+
+    memset(messages, 0, sizeof(messages));
+    for (int d = 0; d < TELEMETRY_BATCH; d++) {
+        iov[d].iov_base = &datagrams[d];
+        iov[d].iov_len = sizeof(TelemetryDatagram);
+        messages[d].msg_hdr.msg_iov = &iov[d];
+        messages[d].msg_hdr.msg_iovlen = 1;
+    }
+
+    printf("Telemetry: listening on 127.0.0.1:%d for %.0f s\n", port, duration);
+    uint64_t start = now_ns(), report = start + 1000000000ull, end = start + (uint64_t)(duration * 1e9);
+    uint64_t interval_records = 0;
+    for (;;) {
+        uint64_t now = now_ns();
+        if (now >= end) break;
+        if (now >= report) {
+            printf("%8.0f records/s  (%llu datagrams, %llu lost so far)\n", (double)interval_records,
+                   (unsigned long long)received, (unsigned long long)lost);
+            interval_records = 0;
+            report += 1000000000ull;
+        }
+
+        struct pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) continue;
+        int n = recvmmsg(fd, messages, TELEMETRY_BATCH, MSG_DONTWAIT, NULL);
+        for (int d = 0; d < n; d++) {
+            LanderTelemetryHeader* header = &datagrams[d].header;
+            if (messages[d].msg_len < sizeof(*header) || header->magic != LANDER_TELEMETRY_MAGIC) continue;
+            if (expected[header->source] && header->sequence + 1 > expected[header->source]) {
+                lost += header->sequence + 1 - expected[header->source];
+            }
+            expected[header->source] = header->sequence + 2;
+            received++;
+            records += header->count;
+            interval_records += header->count;
+            for (int r = 0; r < header->count; r++) {
+                if (datagrams[d].records[r].result == 1) landed++;
+                else if (datagrams[d].records[r].result == -1) crashed++;
+            }
+        }
+    }
+    close(fd);
+
+    printf("Telemetry: %llu records in %llu datagrams (%llu lost), %llu landings, %llu crashes\n",
+           (unsigned long long)records, (unsigned long long)received, (unsigned long long)lost,
+           (unsigned long long)landed, (unsigned long long)crashed);
+    return 0;
+}
+
+// --- Hierarchical timing wheel ---
+
+#define TIMER_TICK_NS 100000ull // 100 us
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS 64
+#define TIMER_WHEEL_LEVELS 5 // 64^5 ticks: about 30 hours at 100 us
+
+// Intrusive: embed one per timer in the owning object. link points at the
+// pointer that points to this timer, so cancelling is O(1) without a prev.
+typedef struct Timer {
+    struct Timer* next;
+    struct Timer** link; // NULL when not scheduled
+    uint64_t expires; // Tick
+    int kind;
+    void* owner;
+} Timer;
+
+typedef struct {
+    uint64_t now; // Last tick processed
+    Timer* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} TimerWheel;
+
+static void timer_wheel_init(TimerWheel* wheel, uint64_t now) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->now = now;
+}
+
+// Level 0 holds timers due within the current 64-tick block; level L those
+// due in the current 64^(L+1) block. Each higher slot is cascaded down when
+// the clock enters its block.
+static void timer_insert(TimerWheel* wheel, Timer* timer) {
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 &&
+           timer->expires >> (TIMER_WHEEL_BITS * (level + 1)) != wheel->now >> (TIMER_WHEEL_BITS * (level + 1))) {
+        level++;
+    }
+    Timer** slot = &wheel->slots[level][(timer->expires >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1)];
+    timer->next = *slot;
+    if (timer->next) timer->next->link = &timer->next;
+    timer->link = slot;
+    *slot = timer;
+}
+
+static void timer_cancel(Timer* timer) {
+    if (!timer->link) return;
+    *timer->link = timer->next;
+    if (timer->next) timer->next->link = timer->link;
+    timer->link = NULL;
+}
+
+// (Re)arms timer for tick `expires`; past ticks fire on the next one
+static void timer_schedule(TimerWheel* wheel, Timer* timer, uint64_t expires) {
+    const uint64_t horizon = 1ull << (TIMER_WHEEL_BITS * (TIMER_WHEEL_LEVELS - 1));
+    timer_cancel(timer);
+    if (expires <= wheel->now) expires = wheel->now + 1;
+    if (expires - wheel->now > horizon) expires = wheel->now + horizon;
+    timer->expires = expires;
+    timer_insert(wheel, timer);
+}
+
+static void timer_advance(TimerWheel* wheel, uint64_t to, void (*fire)(void* context, Timer* timer), void* context) {
+    while (wheel->now < to) {
+        wheel->now++;
+        for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+            if (wheel->now & ((1ull << (TIMER_WHEEL_BITS * level)) - 1)) break;
+            Timer** slot = &wheel->slots[level][(wheel->now >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1)];
+            Timer* timer = *slot;
+            *slot = NULL;
+            while (timer) {
+                Timer* next = timer->next;
+                timer_insert(wheel, timer);
+                timer = next;
+            }
+        }
+
+        Timer** slot = &wheel->slots[0][wheel->now & (TIMER_WHEEL_SLOTS - 1)];
+        Timer* timer;
+        while ((timer = *slot) != NULL) {
+            timer_cancel(timer);
+            fire(context, timer);
+        }
+    }
+}
+
+// Earliest tick anything could fire: the next busy level 0 slot, else the
+// next cascade. Cheap enough to call before every sleep.
+static uint64_t timer_next_tick(TimerWheel* wheel) {
+    uint64_t block_end = (wheel->now | (TIMER_WHEEL_SLOTS - 1)) + 1;
+    for (uint64_t tick = wheel->now + 1; tick < block_end; tick++) {
+        if (wheel->slots[0][tick & (TIMER_WHEEL_SLOTS - 1)]) return tick;
+    }
+    return block_end;
+}
+
+// --- Allocation counting ---
+
+// Built with -DLANDER_COUNT_ALLOCS, every malloc-family call is counted per
+// thread so a load test can prove its steady-state turn path never allocates
+#ifdef LANDER_COUNT_ALLOCS
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* pointer, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+
+static __thread uint64_t thread_allocs;
+
+void* malloc(size_t size) {
+    thread_allocs++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    thread_allocs++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    thread_allocs++;
+    return __libc_realloc(pointer, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    thread_allocs++;
+    return __libc_memalign(alignment, size);
+}
+
+static uint64_t thread_alloc_count(void) {
+    return thread_allocs;
+}
+#else
+static uint64_t thread_alloc_count(void) {
+    return 0;
+}
+#endif
+
+// --- Session slab allocator ---
+
+#define SLAB_OBJECTS 64 // Objects carved from each slab
+#define SLAB_CACHE_MAX 32 // Free objects a thread keeps before giving some back
+#define SLAB_BATCH 16 // Objects moved between a thread cache and the pool at once
+
+typedef struct SlabObject {
+    struct SlabObject* next;
+} SlabObject;
+
+// Shared pool of fixed-size, cache-line aligned objects. Slabs are only
+// returned to the system when the pool is destroyed.
+typedef struct {
+    size_t object_size;
+    pthread_mutex_t lock;
+    SlabObject* free; // Guarded by lock
+    void** slabs;     // Guarded by lock
+    int slab_count, slab_capacity;
+} SlabPool;
+
+// Per-thread front end: alloc and free touch only the local list, and the
+// pool lock is taken once per SLAB_BATCH objects
+typedef struct {
+    SlabPool* pool;
+    SlabObject* free;
+    int count;
+} SlabCache;
+
+static void slab_pool_init(SlabPool* pool, size_t object_size) {
+    memset(pool, 0, sizeof(*pool));
+    pool->object_size = (object_size + 63) & ~(size_t)63;
+    pthread_mutex_init(&pool->lock, NULL);
+}
+
+static void slab_pool_destroy(SlabPool* pool) {
+    for (int i = 0; i < pool->slab_count; i++) free(pool->slabs[i]);
+    free(pool->slabs);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+// Caller holds the lock
+static int slab_grow(SlabPool* pool) {
+    if (pool->slab_count == pool->slab_capacity) {
+        int capacity = pool->slab_capacity ? pool->slab_capacity * 2 : 16;
+        void** slabs = realloc(pool->slabs, (size_t)capacity * sizeof(void*));
+        if (!slabs) return -1;
+        pool->slabs = slabs;
+        pool->slab_capacity = capacity;
+    }
+    char* slab = aligned_alloc(64, pool->object_size * SLAB_OBJECTS);
+    if (!slab) return -1;
+    pool->slabs[pool->slab_count++] = slab;
+    for (int i = SLAB_OBJECTS - 1; i >= 0; i--) {
+        SlabObject* object = (SlabObject*)(slab + (size_t)i * pool->object_size);
+        object->next = pool->free;
+        pool->free = object;
+    }
+    return 0;
+}
+
+static void slab_cache_init(SlabCache* cache, SlabPool* pool) {
+    cache->pool = pool;
+    cache->free = NULL;
+    cache->count = 0;
+}
+
+static void* slab_alloc(SlabCache* cache) {
+    if (!cache->free) {
+        SlabPool* pool = cache->pool;
+        pthread_mutex_lock(&pool->lock);
+        while (cache->count < SLAB_BATCH && (pool->free || slab_grow(pool) == 0)) {
+            SlabObject* object = pool->free;
+            pool->free = object->next;
+            object->next = cache->free;
+            cache->free = object;
+            cache->count++;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        if (!cache->free) return NULL;
+    }
+    SlabObject* object = cache->free;
+    cache->free = object->next;
+    cache->count--;
+    return object;
+}
+
+static void slab_release(SlabCache* cache, int keep) {
+    SlabPool* pool = cache->pool;
+    pthread_mutex_lock(&pool->lock);
+    while (cache->count > keep) {
+        SlabObject* object = cache->free;
+        cache->free = object->next;
+        cache->count--;
+        object->next = pool->free;
+        pool->free = object;
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void slab_free(SlabCache* cache, void* pointer) {
+    SlabObject* object = pointer;
+    object->next = cache->free;
+    cache->free = object;
+    if (++cache->count > SLAB_CACHE_MAX) slab_release(cache, SLAB_CACHE_MAX - SLAB_BATCH);
+}
+
+static void slab_cache_flush(SlabCache* cache) {
+    slab_release(cache, 0);
+}
+
+// --- Load generator ---
+
+#define LOAD_COMMANDS "VWSRXYZ?" // "?" collects unknown script commands
+#define LOAD_COMMAND_COUNT 8
+#define LATENCY_BUCKETS 256
+#define LOAD_PREVIEW_BEAM 256 // Solver beam for what-if previews
+#define LOAD_TIMER_COMMAND 0
+#define LOAD_TIMER_IDLE 1
+
+// Written only by the owning worker; the metrics thread reads them while
+// the test runs, so every access goes through counter_add/counter_get
+typedef struct {
+    uint64_t count[LOAD_COMMAND_COUNT];
+    uint64_t errors[LOAD_COMMAND_COUNT];
+    uint64_t latency[LOAD_COMMAND_COUNT][LATENCY_BUCKETS];
+    uint64_t latency_sum_ns[LOAD_COMMAND_COUNT];
+    uint64_t landed, crashed;
+    uint64_t turns;
+    uint64_t frame_bytes;
+    uint64_t active_sessions;
+    uint64_t cpu_ns[2]; // Command CPU time: [0] plain sessions, [1] preview sessions
+    uint64_t class_commands[2];
+    uint64_t throttled; // Rounds a backlogged session sat out with its budget spent
+    uint64_t throttled_sessions; // Sessions throttled at least once
+    uint64_t idle_timeouts; // Games abandoned by the idle timer
+    uint64_t steady_allocs; // Worker mallocs after warm-up (LANDER_COUNT_ALLOCS builds)
+} LoadStats;
+
+typedef struct LoadClient {
+    Session* session; // From the session slab; replaced per game with --churn
+    uint64_t next_due;
+    Timer command_timer; // Fires at next_due
+    Timer idle_timer;    // Fires when the session goes unserved for --idle-timeout
+    struct LoadClient* ready_next;
+    int script_pos;
+    FILE* frame;
+    int preview; // Runs a what-if solve before each command
+    int throttled;
+    int64_t deficit_ns; // Deficit round robin credit
+    char frame_buffer[FRAME_BUFFER_SIZE];
+} LoadClient;
+
+typedef struct {
+    pthread_t thread;
+    LoadOptions* options;
+    LoadClient* clients;
+    int client_count;
+    uint64_t start_ns, end_ns;
+    LoadStats stats;
+    TelemetryStream* telemetry;
+    LoadClient* all_clients; // Client 0, so records and seeds use global client numbers
+    SlabCache sessions; // This worker's cache of free Session objects
+    QuantileSketch* outcomes; // LOAD_OUTCOME_* sketches of finished games, merged after the run
+    LandingHeatmap* heatmap; // With --heatmap
+    SolverWorkspace* preview; // Only when some clients preview
+    TimerWheel wheel;
+    LoadClient* ready_head; // Clients with a command due, in round robin order
+    LoadClient* ready_tail;
+} LoadWorker;
+
+// Single-writer counters: a relaxed load/store pair compiles to plain moves,
+// so the hot path never pays for a locked instruction
+static inline void counter_add(uint64_t* counter, uint64_t n) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t counter_get(uint64_t* counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+// Log-linear buckets: 4 sub-buckets per power of two, ~19% relative error
+static int latency_bucket(uint64_t ns) {
+    if (ns < 4) return (int)ns;
+    int log2 = 63 - __builtin_clzll(ns);
+    return 4 * (log2 - 1) + (int)((ns >> (log2 - 2)) & 3);
+}
+
+static uint64_t latency_bucket_upper(int bucket) {
+    if (bucket < 4) return (uint64_t)bucket;
+    int log2 = bucket / 4 + 1;
+    return ((uint64_t)(4 + bucket % 4 + 1) << (log2 - 2)) - 1;
+}
+
+static uint64_t latency_percentile(const uint64_t* buckets, uint64_t total, double p) {
+    uint64_t rank = (uint64_t)ceil(p * total), seen = 0;
+    if (rank == 0) rank = 1;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) return latency_bucket_upper(b);
+    }
+    return latency_bucket_upper(LATENCY_BUCKETS - 1);
+}
+
+static char load_next_command(LoadClient* client, LoadOptions* options) {
+    if (client->session->game_over) return 'V';
+    if (!options->script) return autopilot_command(&client->session->state, &client->session->config);
+    char command = options->script[client->script_pos++];
+    if (options->script[client->script_pos] == '\0') client->script_pos = 0;
+    return command;
+}
+
+static void load_worker_ready(LoadWorker* worker, LoadClient* client) {
+    client->ready_next = NULL;
+    if (worker->ready_tail) worker->ready_tail->ready_next = client;
+    else worker->ready_head = client;
+    worker->ready_tail = client;
+}
+
+static void load_worker_timer(void* context, Timer* timer) {
+    LoadWorker* worker = context;
+    LoadClient* client = timer->owner;
+    if (timer->kind == LOAD_TIMER_COMMAND) {
+        load_worker_ready(worker, client);
+    } else if (!client->session->game_over) {
+        // Nobody has served this session for a whole idle period: abandon the game
+        client->session->game_over = 1;
+        counter_add(&worker->stats.idle_timeouts, 1);
+        counter_add(&worker->stats.active_sessions, (uint64_t)-1);
+    }
+}
+
+static void* load_worker_main(void* arg) {
+    LoadWorker* worker = arg;
+    LoadOptions* options = worker->options;
+    LoadStats* stats = &worker->stats;
+    uint64_t period = options->rate > 0 ? (uint64_t)(1e9 / options->rate) : 0;
+    int64_t quantum = (int64_t)(options->cpu_quantum_us * 1e3);
+    uint64_t idle_ticks = (uint64_t)(options->idle_timeout * 1e9) / TIMER_TICK_NS;
+    TimerWheel* wheel = &worker->wheel;
+    GameConfig config = DEFAULT_GAME_CONFIG;
+
+    // Sessions come from this thread's slab cache, so they sit in memory the
+    // worker touched first
+    for (int i = 0; i < worker->client_count; i++) {
+        LoadClient* client = &worker->clients[i];
+        client->session = slab_alloc(&worker->sessions);
+        if (!client->session) {
+            printf("Error: Out of memory for load test sessions.\n");
+            worker->client_count = i;
+            break;
+        }
+        init_session(client->session, &config, (uint32_t)(client - worker->all_clients) + 1);
+    }
+
+    // Stagger clients across one period so they don't fire in lockstep.
+    // Waiting clients sit in the timing wheel; due ones in the ready queue.
+    timer_wheel_init(wheel, worker->start_ns / TIMER_TICK_NS);
+    for (int i = 0; i < worker->client_count; i++) {
+        LoadClient* client = &worker->clients[i];
+        client->next_due = worker->start_ns + period * i / worker->client_count;
+        client->command_timer = (Timer){NULL, NULL, 0, LOAD_TIMER_COMMAND, client};
+        client->idle_timer = (Timer){NULL, NULL, 0, LOAD_TIMER_IDLE, client};
+        timer_schedule(wheel, &client->command_timer, client->next_due / TIMER_TICK_NS);
+    }
+
+    // Allocations are only expected while caches, buffers and timers warm up
+    uint64_t warm_ns = worker->start_ns + (worker->end_ns - worker->start_ns) / 5;
+    uint64_t warm_allocs = 0;
+    int warm = 0;
+
+    uint64_t now;
+    while ((now = now_ns()) < worker->end_ns) {
+        if (!warm && now >= warm_ns) {
+            warm = 1;
+            warm_allocs = thread_alloc_count();
+        }
+        timer_advance(wheel, now / TIMER_TICK_NS, load_worker_timer, worker);
+
+        // One round: every session that was ready when it started
+        LoadClient* round_end = worker->ready_tail;
+        while (worker->ready_head) {
+            LoadClient* client = worker->ready_head;
+            worker->ready_head = client->ready_next;
+            if (!worker->ready_head) worker->ready_tail = NULL;
+            int last_of_round = client == round_end;
+
+            // Deficit round robin: each backlogged session earns one quantum of
+            // CPU per round and runs only while its credit is positive, so a
+            // few expensive sessions can't crowd out the rest. Commands are
+            // charged thread CPU time, so a worker preempted mid-command
+            // doesn't bill the wait to that session.
+            if (quantum > 0) {
+                client->deficit_ns += quantum;
+                if (client->deficit_ns <= 0) {
+                    counter_add(&stats->throttled, 1);
+                    if (!client->throttled) {
+                        client->throttled = 1;
+                        counter_add(&stats->throttled_sessions, 1);
+                    }
+                    load_worker_ready(worker, client); // Still backlogged: next round
+                    if (last_of_round) break;
+                    continue;
+                }
+            }
+
+            char command = load_next_command(client, options);
+            const char* slot = strchr(LOAD_COMMANDS, toupper(command));
+            int index = slot ? (int)(slot - LOAD_COMMANDS) : LOAD_COMMAND_COUNT - 1;
+
+            int was_over = client->session->game_over;
+            uint64_t t0 = now_ns(), cpu0 = thread_cpu_ns();
+            if (client->preview && !client->session->game_over && client->session->state.engines_on) {
+                SolverResult preview;
+                solve_landing(worker->preview, &client->session->state, &client->session->config, &preview);
+            }
+            int result = session_command(client->session, command);
+            if (client->frame && result != SESSION_REJECTED) {
+                rewind(client->frame);
+                display_status(client->frame, &client->session->state, &client->session->config);
+                fflush(client->frame);
+                counter_add(&stats->frame_bytes, (uint64_t)ftell(client->frame));
+            }
+            uint64_t t1 = now_ns(), cpu = thread_cpu_ns() - cpu0;
+
+            counter_add(&stats->count[index], 1);
+            counter_add(&stats->latency[index][latency_bucket(t1 - t0)], 1);
+            counter_add(&stats->latency_sum_ns[index], t1 - t0);
+            counter_add(&stats->cpu_ns[client->preview], cpu);
+            counter_add(&stats->class_commands[client->preview], 1);
+            if (result == SESSION_REJECTED) counter_add(&stats->errors[index], 1);
+            else if (result == SESSION_LANDED) counter_add(&stats->landed, 1);
+            else if (result == SESSION_CRASHED) counter_add(&stats->crashed, 1);
+            if (result != SESSION_REJECTED && strchr("XYZ", toupper(command))) counter_add(&stats->turns, 1);
+            if (was_over && !client->session->game_over) counter_add(&stats->active_sessions, 1);
+            if (!was_over && client->session->game_over) counter_add(&stats->active_sessions, (uint64_t)-1);
+
+            if (worker->telemetry) {
+                Session* session = client->session;
+                LanderTelemetryRecord* record = telemetry_next(worker->telemetry, t1);
+                record->digest = session->digest;
+                record->session = (uint32_t)(client - worker->all_clients);
+                record->turn = (uint32_t)session->turn;
+                telemetry_fill_state(record, &session->state);
+                record->command = (char)toupper(command);
+                record->result = result == SESSION_REJECTED ? 2 : result == SESSION_LANDED ? 1 : result == SESSION_CRASHED ? -1 : 0;
+            }
+            if (worker->outcomes && (result == SESSION_LANDED || result == SESSION_CRASHED)) {
+                sketch_add(&worker->outcomes[LOAD_OUTCOME_IMPACT], fabs(client->session->state.vel_v));
+                sketch_add(&worker->outcomes[LOAD_OUTCOME_FUEL], client->session->state.C);
+                sketch_add(&worker->outcomes[LOAD_OUTCOME_TURNS], client->session->turn);
+            }
+            if (worker->heatmap && (result == SESSION_LANDED || result == SESSION_CRASHED)) {
+                GameState* state = &client->session->state;
+                heatmap_add(worker->heatmap, state->A, state->vel_h, state->vel_v, result == SESSION_LANDED);
+            }
+            if (options->churn && (result == SESSION_LANDED || result == SESSION_CRASHED)) {
+                // The player leaves; a new connection takes over the client slot
+                uint32_t seed = client->session->rng;
+                slab_free(&worker->sessions, client->session);
+                client->session = slab_alloc(&worker->sessions);
+                if (!client->session) {
+                    // Dropped like a client that failed to set up: no more timers or rounds
+                    printf("Error: Out of memory for load test sessions.\n");
+                    timer_cancel(&client->idle_timer);
+                    timer_cancel(&client->command_timer);
+                    if (last_of_round) break;
+                    continue;
+                }
+                init_session(client->session, &config, seed);
+            }
+            if (idle_ticks) timer_schedule(wheel, &client->idle_timer, t1 / TIMER_TICK_NS + idle_ticks);
+
+            client->next_due += period;
+            int backlogged = client->next_due <= t1;
+            if (quantum > 0) {
+                client->deficit_ns -= (int64_t)cpu;
+                // Credit doesn't bank while a session has nothing queued
+                if (!backlogged && client->deficit_ns > 0) client->deficit_ns = 0;
+                if (client->deficit_ns > quantum) client->deficit_ns = quantum;
+            }
+            if (backlogged) load_worker_ready(worker, client);
+            else timer_schedule(wheel, &client->command_timer, client->next_due / TIMER_TICK_NS);
+            if (last_of_round) break;
+        }
+        if (worker->telemetry) telemetry_tick(worker->telemetry, now_ns());
+
+        if (!worker->ready_head) {
+            now = now_ns();
+            uint64_t next_wake = timer_next_tick(wheel) * TIMER_TICK_NS;
+            if (next_wake > worker->end_ns) next_wake = worker->end_ns;
+            uint64_t flush_due = worker->telemetry ? telemetry_deadline(worker->telemetry) : 0;
+            if (flush_due && next_wake > flush_due) {
+                next_wake = flush_due; // Wake to flush a partial batch
+            }
+            if (next_wake > now) {
+                uint64_t wait = next_wake - now;
+                struct timespec ts = {(time_t)(wait / 1000000000ull), (long)(wait % 1000000000ull)};
+                nanosleep(&ts, NULL);
+            }
+        }
+    }
+    if (warm) stats->steady_allocs = thread_alloc_count() - warm_allocs;
+    if (worker->telemetry) telemetry_flush(worker->telemetry);
+
+    for (int i = 0; i < worker->client_count; i++) {
+        if (worker->clients[i].session) slab_free(&worker->sessions, worker->clients[i].session);
+    }
+    slab_cache_flush(&worker->sessions);
+    return NULL;
+}
+
+// Outcome table over LOAD_OUTCOME_* sketches, shared with the Monte Carlo run
+// --- Prometheus metrics endpoint ---
+
+typedef struct {
+    pthread_t thread;
+    int listen_fd;
+    LoadWorker* workers;
+    int worker_count;
+    pthread_mutex_t lock; // Guards client_fd against stop_metrics_server
+    int client_fd;        // Connection being served, -1 between requests
+} MetricsServer;
+
+#define METRICS_CLIENT_TIMEOUT_MS 1000
+
+static const double METRICS_LATENCY_BOUNDS[] = {1e-7, 2.5e-7, 5e-7, 1e-6, 2.5e-6, 5e-6, 1e-5, 1e-4, 1e-3, 1e-2};
+#define METRICS_LATENCY_BOUND_COUNT (int)(sizeof(METRICS_LATENCY_BOUNDS) / sizeof(METRICS_LATENCY_BOUNDS[0]))
+
+static uint64_t metrics_sum(MetricsServer* server, size_t offset) {
+    uint64_t total = 0;
+    for (int t = 0; t < server->worker_count; t++) {
+        total += counter_get((uint64_t*)((char*)&server->workers[t].stats + offset));
+    }
+    return total;
+}
+
+#define METRICS_SUM(server, field) metrics_sum(server, offsetof(LoadStats, field))
+
+static void write_metrics(FILE* out, MetricsServer* server) {
+    fprintf(out, "# HELP lander_active_sessions Sessions with a game in progress.\n");
+    fprintf(out, "# TYPE lander_active_sessions gauge\n");
+    fprintf(out, "lander_active_sessions %lld\n", (long long)(int64_t)METRICS_SUM(server, active_sessions));
+
+    fprintf(out, "# HELP lander_turns_total Simulated turns (accepted X, Y and Z commands).\n");
+    fprintf(out, "# TYPE lander_turns_total counter\n");
+    fprintf(out, "lander_turns_total %llu\n", (unsigned long long)METRICS_SUM(server, turns));
+
+    fprintf(out, "# HELP lander_games_finished_total Games finished, by outcome.\n");
+    fprintf(out, "# TYPE lander_games_finished_total counter\n");
+    fprintf(out, "lander_games_finished_total{outcome=\"landed\"} %llu\n", (unsigned long long)METRICS_SUM(server, landed));
+    fprintf(out, "lander_games_finished_total{outcome=\"crashed\"} %llu\n", (unsigned long long)METRICS_SUM(server, crashed));
+
+    fprintf(out, "# HELP lander_session_cpu_seconds_total CPU time spent applying commands, by session class.\n");
+    fprintf(out, "# TYPE lander_session_cpu_seconds_total counter\n");
+    fprintf(out, "lander_session_cpu_seconds_total{class=\"plain\"} %.9f\n", METRICS_SUM(server, cpu_ns[0]) / 1e9);
+    fprintf(out, "lander_session_cpu_seconds_total{class=\"preview\"} %.9f\n", METRICS_SUM(server, cpu_ns[1]) / 1e9);
+
+    fprintf(out, "# HELP lander_throttled_rounds_total Scheduling rounds a session skipped with its CPU budget spent.\n");
+    fprintf(out, "# TYPE lander_throttled_rounds_total counter\n");
+    fprintf(out, "lander_throttled_rounds_total %llu\n", (unsigned long long)METRICS_SUM(server, throttled));
+
+    fprintf(out, "# HELP lander_throttled_sessions_total Sessions throttled at least once.\n");
+    fprintf(out, "# TYPE lander_throttled_sessions_total counter\n");
+    fprintf(out, "lander_throttled_sessions_total %llu\n", (unsigned long long)METRICS_SUM(server, throttled_sessions));
+
+    fprintf(out, "# HELP lander_idle_timeouts_total Games abandoned by the idle timer.\n");
+    fprintf(out, "# TYPE lander_idle_timeouts_total counter\n");
+    fprintf(out, "lander_idle_timeouts_total %llu\n", (unsigned long long)METRICS_SUM(server, idle_timeouts));
+
+    fprintf(out, "# HELP lander_frame_bytes_total Bytes of status frames rendered for clients.\n");
+    fprintf(out, "# TYPE lander_frame_bytes_total counter\n");
+    fprintf(out, "lander_frame_bytes_total %llu\n", (unsigned long long)METRICS_SUM(server, frame_bytes));
+
+    fprintf(out, "# HELP lander_command_errors_total Rejected commands, by command.\n");
+    fprintf(out, "# TYPE lander_command_errors_total counter\n");
+    for (int c = 0; c < LOAD_COMMAND_COUNT; c++) {
+        fprintf(out, "lander_command_errors_total{command=\"%c\"} %llu\n", LOAD_COMMANDS[c],
+                (unsigned long long)METRICS_SUM(server, errors[c]));
+    }
+
+    fprintf(out, "# HELP lander_command_latency_seconds Time to apply one client command.\n");
+    fprintf(out, "# TYPE lander_command_latency_seconds histogram\n");
+    for (int c = 0; c < LOAD_COMMAND_COUNT; c++) {
+        uint64_t buckets[LATENCY_BUCKETS];
+        for (int b = 0; b < LATENCY_BUCKETS; b++) buckets[b] = METRICS_SUM(server, latency[c][b]);
+
+        uint64_t cumulative = 0;
+        int b = 0;
+        for (int i = 0; i < METRICS_LATENCY_BOUND_COUNT; i++) {
+            while (b < LATENCY_BUCKETS && latency_bucket_upper(b) <= METRICS_LATENCY_BOUNDS[i] * 1e9) {
+                cumulative += buckets[b++];
+            }
+            fprintf(out, "lander_command_latency_seconds_bucket{command=\"%c\",le=\"%g\"} %llu\n",
+                    LOAD_COMMANDS[c], METRICS_LATENCY_BOUNDS[i], (unsigned long long)cumulative);
+        }
+        uint64_t count = METRICS_SUM(server, count[c]);
+        fprintf(out, "lander_command_latency_seconds_bucket{command=\"%c\",le=\"+Inf\"} %llu\n",
+                LOAD_COMMANDS[c], (unsigned long long)count);
+        fprintf(out, "lander_command_latency_seconds_sum{command=\"%c\"} %.9f\n",
+                LOAD_COMMANDS[c], METRICS_SUM(server, latency_sum_ns[c]) / 1e9);
+        fprintf(out, "lander_command_latency_seconds_count{command=\"%c\"} %llu\n",
+                LOAD_COMMANDS[c], (unsigned long long)count);
+    }
+}
+
+static void* metrics_server_main(void* arg) {
+    MetricsServer* server = arg;
+    char request[1024];
+
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) break; // Listening socket shut down at the end of the run
+
+        // A client that never sends or reads must not hold up the end of the run
+        struct timeval timeout = {METRICS_CLIENT_TIMEOUT_MS / 1000, METRICS_CLIENT_TIMEOUT_MS % 1000 * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        pthread_mutex_lock(&server->lock);
+        server->client_fd = fd;
+        pthread_mutex_unlock(&server->lock);
+
+        // Any request gets the metrics page; a timeout or a stop gets nothing
+        char* body = NULL;
+        size_t body_len = 0;
+        FILE* out = recv(fd, request, sizeof(request), 0) > 0 ? open_memstream(&body, &body_len) : NULL;
+        if (out) {
+            char header[128];
+            write_metrics(out, server);
+            fclose(out);
+            int header_len = snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; "
+                                      "version=0.0.4\r\nContent-Length: %zu\r\n\r\n", body_len);
+            if (send(fd, header, (size_t)header_len, MSG_NOSIGNAL) != header_len) body_len = 0;
+            for (size_t sent = 0; sent < body_len;) {
+                ssize_t n = send(fd, body + sent, body_len - sent, MSG_NOSIGNAL);
+                if (n <= 0) break;
+                sent += (size_t)n;
+            }
+            free(body);
+        }
+        pthread_mutex_lock(&server->lock);
+        server->client_fd = -1;
+        pthread_mutex_unlock(&server->lock);
+        close(fd);
+    }
+    return NULL;
+}
+
+static int start_metrics_server(MetricsServer* server, int port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int reuse = 1;
+    server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listen_fd < 0) return -1;
+    setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(server->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, 16) != 0 ||
+        pthread_create(&server->thread, NULL, metrics_server_main, server) != 0) {
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+static void stop_metrics_server(MetricsServer* server) {
+    if (server->listen_fd < 0) return;
+    shutdown(server->listen_fd, SHUT_RDWR);
+    // Wake a request still in flight; the server thread closes it
+    pthread_mutex_lock(&server->lock);
+    if (server->client_fd >= 0) shutdown(server->client_fd, SHUT_RDWR);
+    pthread_mutex_unlock(&server->lock);
+    pthread_join(server->thread, NULL);
+    close(server->listen_fd);
+    server->listen_fd = -1;
+}
+
+int run_load_test(LoadOptions* options) {
+    SlabPool sessions;
+#ifndef LANDER_COUNT_ALLOCS
+    if (options->check_allocs) {
+        printf("Error: --check-allocs needs a build with -DLANDER_COUNT_ALLOCS.\n");
+        return 1;
+    }
+#endif
+    if (options->threads < 1) options->threads = 1;
+    if (options->threads > options->clients) options->threads = options->clients;
+
+    LoadClient* clients = calloc(options->clients, sizeof(LoadClient));
+    LoadWorker* workers = calloc(options->threads, sizeof(LoadWorker));
+    if (!clients || !workers) {
+        printf("Error: Could not allocate %d load test clients.\n", options->clients);
+        free(clients);
+        free(workers);
+        return 1;
+    }
+
+    // Every worker needs its shard, or its touchdowns would be missing from the maps
+    LandingHeatmap** heatmaps = NULL;
+    if (options->heatmap) {
+        int ready = 0;
+        heatmaps = calloc((size_t)options->threads, sizeof(LandingHeatmap*));
+        while (heatmaps && ready < options->threads && (heatmaps[ready] = calloc(1, sizeof(LandingHeatmap)))) ready++;
+        if (ready < options->threads) {
+            printf("Error: Could not allocate touchdown heatmaps.\n");
+            for (int t = 0; heatmaps && t < ready; t++) free(heatmaps[t]);
+            free(heatmaps);
+            free(clients);
+            free(workers);
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < options->clients; i++) {
+        clients[i].preview = floor((i + 1) * options->preview_fraction) > floor(i * options->preview_fraction);
+        if (options->frames) {
+            clients[i].frame = fmemopen(clients[i].frame_buffer, FRAME_BUFFER_SIZE, "w");
+        }
+    }
+
+    printf("Load test: %d clients on %d threads, %s, %.1f commands/s per client%s, %.0f s\n",
+           options->clients, options->threads, options->script ? options->script : "autopilot",
+           options->rate, options->rate > 0 ? "" : " (unthrottled)", options->duration);
+
+    slab_pool_init(&sessions, sizeof(Session));
+    uint64_t start = now_ns();
+    for (int t = 0; t < options->threads; t++) {
+        int first = (int)((int64_t)options->clients * t / options->threads);
+        int last = (int)((int64_t)options->clients * (t + 1) / options->threads);
+        workers[t].options = options;
+        workers[t].clients = clients + first;
+        workers[t].client_count = last - first;
+        workers[t].start_ns = start;
+        workers[t].end_ns = start + (uint64_t)(options->duration * 1e9);
+        workers[t].all_clients = clients;
+        slab_cache_init(&workers[t].sessions, &sessions);
+        if (heatmaps) workers[t].heatmap = heatmaps[t];
+        workers[t].outcomes = malloc(LOAD_OUTCOME_COUNT * sizeof(QuantileSketch));
+        for (int k = 0; workers[t].outcomes && k < LOAD_OUTCOME_COUNT; k++) {
+            sketch_init(&workers[t].outcomes[k], (uint32_t)(t * LOAD_OUTCOME_COUNT + k + 1));
+        }
+        if (options->telemetry_port > 0) workers[t].telemetry = telemetry_open(options->telemetry_port, t);
+        if (options->preview_fraction > 0) {
+            workers[t].preview = malloc(sizeof(SolverWorkspace));
+            if (workers[t].preview && solver_init(workers[t].preview, LOAD_PREVIEW_BEAM) != 0) {
+                free(workers[t].preview);
+                workers[t].preview = NULL;
+            }
+            if (!workers[t].preview) {
+                for (int i = first; i < last; i++) clients[i].preview = 0;
+            }
+        }
+        pthread_create(&workers[t].thread, NULL, load_worker_main, &workers[t]);
+    }
+
+    MetricsServer metrics = {0, -1, workers, options->threads, PTHREAD_MUTEX_INITIALIZER, -1};
+    if (options->metrics_port > 0) {
+        if (start_metrics_server(&metrics, options->metrics_port) == 0) {
+            printf("Metrics: http://127.0.0.1:%d/metrics\n", options->metrics_port);
+        } else {
+            printf("Error: Could not serve metrics on port %d.\n", options->metrics_port);
+        }
+    }
+
+    LoadStats total;
+    memset(&total, 0, sizeof(total));
+    for (int t = 0; t < options->threads; t++) {
+        pthread_join(workers[t].thread, NULL);
+        for (int c = 0; c < LOAD_COMMAND_COUNT; c++) {
+            total.count[c] += workers[t].stats.count[c];
+            total.errors[c] += workers[t].stats.errors[c];
+            for (int b = 0; b < LATENCY_BUCKETS; b++) total.latency[c][b] += workers[t].stats.latency[c][b];
+        }
+        total.landed += workers[t].stats.landed;
+        total.crashed += workers[t].stats.crashed;
+        total.frame_bytes += workers[t].stats.frame_bytes;
+        for (int k = 0; k < 2; k++) {
+            total.cpu_ns[k] += workers[t].stats.cpu_ns[k];
+            total.class_commands[k] += workers[t].stats.class_commands[k];
+        }
+        total.throttled += workers[t].stats.throttled;
+        total.throttled_sessions += workers[t].stats.throttled_sessions;
+        total.idle_timeouts += workers[t].stats.idle_timeouts;
+        total.steady_allocs += workers[t].stats.steady_allocs;
+        if (workers[t].preview) {
+            solver_free(workers[t].preview);
+            free(workers[t].preview);
+        }
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+    stop_metrics_server(&metrics);
+
+    uint64_t commands = 0, errors = 0;
+    for (int c = 0; c < LOAD_COMMAND_COUNT; c++) {
+        commands += total.count[c];
+        errors += total.errors[c];
+    }
+
+    printf("\n=== LOAD TEST RESULTS ===\n");
+    printf("Commands:   %llu (%.0f/s)\n", (unsigned long long)commands, commands / elapsed);
+    printf("Games:      %llu finished (%.0f/s), %llu landed, %llu crashed\n",
+           (unsigned long long)(total.landed + total.crashed), (total.landed + total.crashed) / elapsed,
+           (unsigned long long)total.landed, (unsigned long long)total.crashed);
+    printf("Errors:     %llu rejected commands\n", (unsigned long long)errors);
+    if (options->rate > 0) {
+        double achieved = commands / elapsed / options->clients;
+        printf("Per client: %.2f of %.2f commands/s%s\n", achieved, options->rate,
+               achieved < options->rate * 0.95 ? "  ** SATURATED **" : "");
+    }
+
+    printf("\nCmd      Count     Errors   p50(us)   p90(us)   p99(us)   max(us)\n");
+    for (int c = 0; c < LOAD_COMMAND_COUNT; c++) {
+        if (total.count[c] == 0) continue;
+        uint64_t max_ns = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) if (total.latency[c][b]) max_ns = latency_bucket_upper(b);
+        printf("%c %12llu %10llu %9.2f %9.2f %9.2f %9.2f\n", LOAD_COMMANDS[c],
+               (unsigned long long)total.count[c], (unsigned long long)total.errors[c],
+               latency_percentile(total.latency[c], total.count[c], 0.50) / 1e3,
+               latency_percentile(total.latency[c], total.count[c], 0.90) / 1e3,
+               latency_percentile(total.latency[c], total.count[c], 0.99) / 1e3,
+               max_ns / 1e3);
+    }
+
+    if (options->frames) {
+        printf("\nFrames:     %.1f MB rendered (%.0f bytes/frame)\n", total.frame_bytes / 1e6,
+               commands > errors ? (double)total.frame_bytes / (commands - errors) : 0.0);
+    }
+
+    if (options->preview_fraction > 0 || total.throttled > 0) {
+        int previewers = 0;
+        for (int i = 0; i < options->clients; i++) previewers += clients[i].preview;
+        int plain = options->clients - previewers;
+        printf("\nCPU:        plain sessions %.1f ms (%.2f us/command), preview sessions %.1f ms (%.2f us/command)\n",
+               total.cpu_ns[0] / 1e6, total.class_commands[0] ? total.cpu_ns[0] / 1e3 / total.class_commands[0] : 0.0,
+               total.cpu_ns[1] / 1e6, total.class_commands[1] ? total.cpu_ns[1] / 1e3 / total.class_commands[1] : 0.0);
+        printf("Throughput: %.1f commands/s per plain session, %.1f per preview session\n",
+               plain ? total.class_commands[0] / elapsed / plain : 0.0,
+               previewers ? total.class_commands[1] / elapsed / previewers : 0.0);
+        printf("Fairness:   %llu throttled rounds, %llu sessions throttled (quantum %.0f us)\n",
+               (unsigned long long)total.throttled, (unsigned long long)total.throttled_sessions,
+               options->cpu_quantum_us);
+    }
+
+    if (options->idle_timeout > 0) {
+        printf("Idle:       %llu games abandoned after %.1f s unserved\n", (unsigned long long)total.idle_timeouts,
+               options->idle_timeout);
+    }
+
+    QuantileSketch* outcomes = malloc(LOAD_OUTCOME_COUNT * sizeof(QuantileSketch));
+    if (outcomes) {
+        for (int k = 0; k < LOAD_OUTCOME_COUNT; k++) {
+            sketch_init(&outcomes[k], (uint32_t)k + 1);
+            for (int t = 0; t < options->threads; t++) {
+                if (workers[t].outcomes) sketch_merge(&outcomes[k], &workers[t].outcomes[k]);
+            }
+        }
+        report_outcomes(outcomes);
+        free(outcomes);
+    }
+    for (int t = 0; t < options->threads; t++) free(workers[t].outcomes);
+
+    int status = 0;
+    if (heatmaps) {
+        if (heatmap_export_shards(heatmaps, options->threads, options->heatmap) != 0) status = 1;
+        for (int t = 0; t < options->threads; t++) free(heatmaps[t]);
+        free(heatmaps);
+    }
+    printf("Sessions:   %d slabs of %d (%zu bytes each)%s\n", sessions.slab_count, SLAB_OBJECTS,
+           sessions.object_size, options->churn ? ", replaced after every game" : "");
+#ifdef LANDER_COUNT_ALLOCS
+    printf("Allocations: %llu mallocs on worker threads after warm-up\n", (unsigned long long)total.steady_allocs);
+    if (options->check_allocs && total.steady_allocs > 0) {
+        printf("** FAILED: the steady-state turn path allocated **\n");
+        status = 1;
+    }
+#endif
+    slab_pool_destroy(&sessions);
+
+    if (options->telemetry_port > 0) {
+        uint64_t records = 0, datagrams = 0, syscalls = 0;
+        for (int t = 0; t < options->threads; t++) {
+            if (!workers[t].telemetry) continue;
+            telemetry_totals(workers[t].telemetry, &records, &datagrams, &syscalls);
+            telemetry_close(workers[t].telemetry);
+        }
+        printf("\nTelemetry:  %llu records in %llu datagrams, %llu sendmmsg calls (%.1f/ms)\n",
+               (unsigned long long)records, (unsigned long long)datagrams, (unsigned long long)syscalls,
+               syscalls / (elapsed * 1e3));
+    }
+
+    for (int i = 0; i < options->clients; i++) {
+        if (clients[i].frame) fclose(clients[i].frame);
+    }
+    free(clients);
+    free(workers);
+    return status;
+}
+
+// --- Shared-memory benchmark ---
+
+int run_shm_benchmark(int n_envs, int obs_layout, int steps) {
+    char name[64];
+    snprintf(name, sizeof(name), "/moon_lander_bench_%d", (int)getpid());
+
+    pid_t server = fork();
+    if (server < 0) {
+        printf("Error: Could not start the shared-memory server.\n");
+        return 1;
+    }
+    if (server == 0) _exit(lander_shm_serve(name, n_envs, obs_layout, 1, 0) == 0 ? 0 : 1);
+
+    LanderShmClient* client = lander_shm_connect(name);
+    if (!client) {
+        printf("Error: Could not connect to shared memory %s.\n", name);
+        kill(server, SIGTERM);
+        waitpid(server, NULL, 0);
+        return 1;
+    }
+
+    const void* observations;
+    const float* rewards;
+    const uint8_t* dones;
+    uint64_t latency[LATENCY_BUCKETS] = {0};
+    uint64_t episodes = 0;
+    uint32_t rng = 12345;
+
+    int failed = lander_shm_reset(client, &observations) != 0;
+    uint64_t start = now_ns();
+    for (int step = 0; step < steps && !failed; step++) {
+        int* actions = lander_shm_actions(client);
+        for (int i = 0; i < n_envs; i++) actions[i] = (int)(lander_rand(&rng) % 3);
+
+        uint64_t t0 = now_ns();
+        if (lander_shm_step(client, &observations, &rewards, &dones) != 0) {
+            failed = 1;
+            break;
+        }
+        latency[latency_bucket(now_ns() - t0)]++;
+        for (int i = 0; i < n_envs; i++) episodes += dones[i];
+    }
+    double elapsed = (now_ns() - start) / 1e9;
+    lander_shm_close(client);
+    waitpid(server, NULL, 0);
+    if (failed) {
+        printf("Error: The shared-memory server exited mid-run.\n");
+        return 1;
+    }
+
+    printf("Shared-memory benchmark: %d steps x %d envs, %zu-byte observations\n",
+           steps, n_envs, lander_obs_row_bytes(obs_layout));
+    printf("Steps/s:      %.0f (%.0f env steps/s)\n", steps / elapsed, (double)steps * n_envs / elapsed);
+    printf("Round trip:   p50 %.2f us, p99 %.2f us\n",
+           latency_percentile(latency, (uint64_t)steps, 0.50) / 1e3,
+           latency_percentile(latency, (uint64_t)steps, 0.99) / 1e3);
+    printf("Episodes:     %llu finished\n", (unsigned long long)episodes);
+    return 0;
+}
+
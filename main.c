@@ -3,74 +3,424 @@
 #include <time.h>
 #include <ctype.h>
 #include <string.h>
-#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <endian.h>
+#include "lander.h"
 
-// Game configuration
+#define RECOVERY_HISTORY 1024 // Turns kept for the point-of-no-return analysis
+
+// The current game's turns, owned by the game loop
 typedef struct {
-    double gravity;
-    double engine_force;
-    int initial_fuel;
-    int display_delta_v;
-} GameConfig;
+    GameState states[RECOVERY_HISTORY]; // State at the start of each turn
+    char commands[RECOVERY_HISTORY];
+    int turns;
+    SolverWorkspace workspace; // Set up on the first crash
+    int workspace_ready;
+} RecoveryHistory;
+
+#define MAX_AUTOPILOTS 16
+#define MAX_SEED_PREDICATES 16
 
-// Landing radar data
+// Command line options
 typedef struct {
-    int active;
-    int turns_remaining;
-    double terrain_height[21];
-    double safe_landing_x;
-    double safe_landing_score;
-} LandingRadar;
+    GameConfig config;
+    LoadOptions load;
+    int threads; // 0 = all cores (the load test defaults to one thread)
+    int telemetry_listen_port;
+    const char* shm_name;
+    int shm_bench_steps;
+    int n_envs;
+    int obs_layout;
+    int check_batch_games;
+    const char* curriculum_path;
+    int curriculum_starts;
+    double difficulty; // Quantile to play, -1 = any start
+    const char* versus_path;
+    int versus_host;
+    const char* autopilot_paths[MAX_AUTOPILOTS];
+    int autopilot_count;
+    int autopilot_games;
+    long long monte_carlo_games;
+    const char* map_prefix;
+    int map_seeds;
+    int map_solver;
+    int sweep_samples;
+    int sweep_grid;
+    int sweep_games;
+    double calibrate_target;
+    long long calibrate_games;
+    int validate_starts;
+    SeedPredicate seed_predicates[MAX_SEED_PREDICATES];
+    int seed_predicate_count;
+    int seed_matches;
+    int ad_bench_rollouts;
+    int optimize_starts;
+    int tournament_seeds;
+    const char* spectate_host_path;
+    const char* spectate_path;
+    const char* record_path;
+    const char* replay_path;
+    const char* diff_paths[2];
+} Options;
+
+enum { OPTION_FLAG, OPTION_INT, OPTION_LONG, OPTION_DOUBLE, OPTION_STRING, OPTION_PAIR, OPTION_OBS,
+       OPTION_VERSUS_HOST, OPTION_VERSUS_JOIN, OPTION_AUTOPILOT, OPTION_FIND_SEED, OPTION_HELP };
 
 typedef struct {
-    double A, B; // A: horizontal position, B: altitude
-    double vel_h, vel_v;
-    double prev_vel_h, prev_vel_v; // For delta V calculation
-    int C; // Fuel
-    int engines_on;
-    double time_step;
-    LandingRadar radar;
-} GameState;
+    const char* name;
+    const char* alias;
+    int kind;
+    size_t offset; // Field of Options the value is stored in
+    const char* help;
+} OptionSpec;
+
+#define OPTION_AT(field) offsetof(Options, field)
+
+// In --help order
+static const OptionSpec OPTION_SPECS[] = {
+    {"--delta-v", "-d", OPTION_FLAG, OPTION_AT(config.display_delta_v),
+     "--delta-v, -d    Display velocity changes as Delta V"},
+    {"--load-test", NULL, OPTION_INT, OPTION_AT(load.clients),
+     "--load-test N    Run N simulated clients headless and report throughput"},
+    {"--threads", NULL, OPTION_INT, OPTION_AT(threads),
+     "--threads N      Worker threads (default: 1 for the load test, all cores otherwise)"},
+    {"--rate", NULL, OPTION_DOUBLE, OPTION_AT(load.rate),
+     "--rate R         Commands per second per client (default 0 = unthrottled)"},
+    {"--duration", NULL, OPTION_DOUBLE, OPTION_AT(load.duration),
+     "--duration S     Load test duration in seconds (default 10)"},
+    {"--script", NULL, OPTION_STRING, OPTION_AT(load.script),
+     "--script CMDS    Replay CMDS (e.g. WXXYZ) in a loop instead of the autopilot"},
+    {"--frames", NULL, OPTION_FLAG, OPTION_AT(load.frames),
+     "--frames         Render a status frame per load test command"},
+    {"--preview-fraction", NULL, OPTION_DOUBLE, OPTION_AT(load.preview_fraction),
+     "--preview-fraction F  Share of load test clients running a solver preview per command"},
+    {"--churn", NULL, OPTION_FLAG, OPTION_AT(load.churn),
+     "--churn          Replace each load test session with a new one after every game"},
+    {"--check-allocs", NULL, OPTION_FLAG, OPTION_AT(load.check_allocs),
+     "--check-allocs   Fail the load test if workers call malloc after warm-up"},
+    {"--idle-timeout", NULL, OPTION_DOUBLE, OPTION_AT(load.idle_timeout),
+     "--idle-timeout S Abandon load test games left unserved for S seconds"},
+    {"--cpu-quantum", NULL, OPTION_DOUBLE, OPTION_AT(load.cpu_quantum_us),
+     "--cpu-quantum US Per-session CPU quantum for fair scheduling (default 100, 0 = off)"},
+    {"--metrics-port", NULL, OPTION_INT, OPTION_AT(load.metrics_port),
+     "--metrics-port P Serve Prometheus metrics on 127.0.0.1:P during the load test"},
+    {"--telemetry-port", NULL, OPTION_INT, OPTION_AT(load.telemetry_port),
+     "--telemetry-port P  Stream per-turn UDP telemetry to 127.0.0.1:P (load test, shm server)"},
+    {"--telemetry-listen", NULL, OPTION_INT, OPTION_AT(telemetry_listen_port),
+     "--telemetry-listen P  Summarize telemetry arriving on port P for --duration seconds"},
+    {"--shm-serve", NULL, OPTION_STRING, OPTION_AT(shm_name),
+     "--shm-serve NAME Serve a vectorized environment over shared memory NAME"},
+    {"--shm-bench", NULL, OPTION_INT, OPTION_AT(shm_bench_steps),
+     "--shm-bench N    Time N shared-memory steps against a forked server"},
+    {"--envs", NULL, OPTION_INT, OPTION_AT(n_envs),
+     "--envs N         Environments per vectorized step (default 64)"},
+    {"--obs", NULL, OPTION_OBS, OPTION_AT(obs_layout),
+     "--obs F          Observation encoding: f32 (default), f16 or i8"},
+    {"--check-batch", NULL, OPTION_INT, OPTION_AT(check_batch_games),
+     "--check-batch N  Check the batch engine against simulate_turn on N seeded games"},
+    {"--curriculum", NULL, OPTION_STRING, OPTION_AT(curriculum_path),
+     "--curriculum F   Difficulty index file; built and saved if F does not exist"},
+    {"--starts", NULL, OPTION_INT, OPTION_AT(curriculum_starts),
+     "--starts N       Starts to rank when building a difficulty index (default 1000)"},
+    {"--difficulty", NULL, OPTION_DOUBLE, OPTION_AT(difficulty),
+     "--difficulty Q   Play starts from difficulty quantile Q (0 easiest, 1 hardest)"},
+    {"--versus-host", NULL, OPTION_VERSUS_HOST, OPTION_AT(versus_path),
+     "--versus-host P  Host a head-to-head game on Unix socket P"},
+    {"--versus-join", NULL, OPTION_VERSUS_JOIN, OPTION_AT(versus_path),
+     "--versus-join P  Join the head-to-head game hosted on Unix socket P"},
+    {"--autopilot-games", NULL, OPTION_INT, OPTION_AT(autopilot_games),
+     "--autopilot-games N  Fly N games with the batch autopilot and report results"},
+    {"--autopilot", NULL, OPTION_AUTOPILOT, OPTION_AT(autopilot_paths),
+     "--autopilot SO   Use the autopilot plugin SO (default: built-in); repeatable"},
+    {"--monte-carlo", NULL, OPTION_LONG, OPTION_AT(monte_carlo_games),
+     "--monte-carlo N  Fly N autopilot games and report outcome quantiles"},
+    {"--heatmap", NULL, OPTION_STRING, OPTION_AT(load.heatmap),
+     "--heatmap P      Write touchdown heatmaps P-position/P-velocity (.ppm, .csv)"},
+    {"--success-map", NULL, OPTION_STRING, OPTION_AT(map_prefix),
+     "--success-map P  Map success rate over starting conditions to P.ppm/P.csv (resumes P.ckpt)"},
+    {"--map-seeds", NULL, OPTION_INT, OPTION_AT(map_seeds),
+     "--map-seeds N    Terrains per success map cell (default 8)"},
+    {"--map-solver", NULL, OPTION_FLAG, OPTION_AT(map_solver),
+     "--map-solver     Map the landing solver's verdict instead of the autopilot"},
+    {"--sweep", NULL, OPTION_INT, OPTION_AT(sweep_samples),
+     "--sweep N        Fly N random (gravity, engine force, fuel) configs and tabulate results"},
+    {"--sweep-grid", NULL, OPTION_INT, OPTION_AT(sweep_grid),
+     "--sweep-grid K   Sweep a K x K x K grid of configs instead"},
+    {"--sweep-games", NULL, OPTION_INT, OPTION_AT(sweep_games),
+     "--sweep-games N  Games per swept config (default 2000)"},
+    {"--calibrate", NULL, OPTION_DOUBLE, OPTION_AT(calibrate_target),
+     "--calibrate P    Find touchdown limits at which the autopilot lands with probability P"},
+    {"--calibrate-games", NULL, OPTION_LONG, OPTION_AT(calibrate_games),
+     "--calibrate-games N  Games per calibration candidate (default 1000000)"},
+    {"--validate-difficulty", NULL, OPTION_INT, OPTION_AT(validate_starts),
+     "--validate-difficulty N  Compare the difficulty estimate with the solver on N starts"},
+    {"--find-seed", NULL, OPTION_FIND_SEED, OPTION_AT(seed_predicates),
+     "--find-seed C    Find seeds whose start meets condition C, e.g. \"distance > 100\"; repeatable\n"
+     "                   Fields: A B vel_h vel_v safe_landing_x safe_landing_score distance difficulty"},
+    {"--matches", NULL, OPTION_INT, OPTION_AT(seed_matches),
+     "--matches N      Seeds to find before stopping (default 10)"},
+    {"--ad-bench", NULL, OPTION_INT, OPTION_AT(ad_bench_rollouts),
+     "--ad-bench N     Time throttle Jacobians (forward-mode derivatives) over N starts"},
+    {"--optimize", NULL, OPTION_INT, OPTION_AT(optimize_starts),
+     "--optimize N     Optimize smooth throttle profiles for N starts and compare with the solver"},
+    {"--tournament", NULL, OPTION_INT, OPTION_AT(tournament_seeds),
+     "--tournament N   Rank the built-in and every --autopilot plugin on N shared seeds"},
+    {"--spectate-host", NULL, OPTION_STRING, OPTION_AT(spectate_host_path),
+     "--spectate-host P  Let spectators watch this game on Unix socket P"},
+    {"--spectate", NULL, OPTION_STRING, OPTION_AT(spectate_path),
+     "--spectate P     Watch the game broadcast on Unix socket P"},
+    {"--record", NULL, OPTION_STRING, OPTION_AT(record_path),
+     "--record F       Record seeds, commands and per-turn state digests to F"},
+    {"--replay", NULL, OPTION_STRING, OPTION_AT(replay_path),
+     "--replay F       Re-simulate recording F and report the first divergent turn"},
+    {"--diff-digests", NULL, OPTION_PAIR, OPTION_AT(diff_paths),
+     "--diff-digests A B  Find the first turn where recordings A and B diverge"},
+    {"--help", "-h", OPTION_HELP, 0,
+     "--help, -h       Show this help message"},
+};
+
+#define OPTION_COUNT (int)(sizeof(OPTION_SPECS) / sizeof(OPTION_SPECS[0]))
 
 // Function Prototypes
-void init_game(GameState* state, GameConfig* config);
-void display_status(GameState* state, GameConfig* config);
+void activate_landing_radar(GameState* state);
+void display_landing_radar(GameState* state);
 char get_command(void);
-void update_physics(GameState* state, GameConfig* config, char move_command);
-int check_landing(GameState* state);
 void save_result(GameState* state, const char* result);
 void configure_game(GameConfig* config);
-void activate_landing_radar(GameState* state);
-void display_landing_radar(GameState* state);
-void generate_terrain_data(GameState* state);
-double calculate_landing_safety(GameState* state, double x_pos);
-void display_visualizer(GameState* state);
-void handle_game_turn(GameState* state, GameConfig* config, char command, int* game_over);
+void handle_game_turn(GameState* state, GameConfig* config, RecoveryHistory* history, char command, int* game_over);
+RecoveryHistory* recovery_create(void);
+void recovery_destroy(RecoveryHistory* history);
+void recovery_reset(RecoveryHistory* history);
+void recovery_record(RecoveryHistory* history, GameState* state, char command);
+void report_point_of_no_return(RecoveryHistory* history, GameConfig* config);
+int run_versus(const char* socket_path, int host, GameConfig* config);
+typedef struct SpectatorHub SpectatorHub;
+SpectatorHub* spectator_hub_start(const char* socket_path);
+void spectator_publish(SpectatorHub* hub, const char* data, size_t length);
+void spectator_hub_stop(SpectatorHub* hub);
+int run_spectate(const char* socket_path);
+int first_divergence(const uint64_t* a, const uint64_t* b, int count);
+int run_replay(const char* path);
+int run_digest_diff(const char* path_a, const char* path_b);
+int parse_options(int argc, char* argv[], Options* options);
+int run_game(Options* options);
 
 int main(int argc, char* argv[]) {
-    GameConfig config = {1.6, 3.0, 50, 0}; // Default: moon gravity, 3 m/s² thrust, 50 fuel
+    Options options;
+    int status = parse_options(argc, argv, &options);
+    if (status >= 0) return status;
+
+    const char* autopilot = options.autopilot_count ? options.autopilot_paths[0] : NULL;
+    int threads = options.threads > 0 ? options.threads : default_thread_count();
+    options.load.threads = options.threads > 0 ? options.threads : 1;
+
+    if (options.load.clients > 0) return run_load_test(&options.load);
+    if (options.telemetry_listen_port > 0) return run_telemetry_listen(options.telemetry_listen_port, options.load.duration);
+    if (options.shm_name) {
+        return lander_shm_serve(options.shm_name, options.n_envs, options.obs_layout, (uint32_t)time(NULL),
+                                options.load.telemetry_port) == 0 ? 0 : 1;
+    }
+    if (options.shm_bench_steps > 0) return run_shm_benchmark(options.n_envs, options.obs_layout, options.shm_bench_steps);
+    if (options.versus_path) return run_versus(options.versus_path, options.versus_host, &options.config);
+    if (options.spectate_path) return run_spectate(options.spectate_path);
+    if (options.autopilot_games > 0) return run_autopilot_games(autopilot, options.autopilot_games);
+    if (options.monte_carlo_games > 0) {
+        return run_monte_carlo(autopilot, options.monte_carlo_games, threads, options.load.heatmap);
+    }
+    if (options.map_prefix) {
+        return run_success_map(options.map_prefix, autopilot, options.map_solver, options.map_seeds, threads);
+    }
+    if (options.sweep_samples > 0 || options.sweep_grid > 0) {
+        return run_config_sweep(autopilot, options.sweep_grid, options.sweep_samples, options.sweep_games, threads);
+    }
+    if (options.calibrate_target > 0) {
+        return run_calibration(autopilot, options.calibrate_target, options.calibrate_games, threads);
+    }
+    if (options.validate_starts > 0) return run_difficulty_validation(options.validate_starts, threads);
+    if (options.seed_predicate_count > 0) {
+        return run_seed_search(options.seed_predicates, options.seed_predicate_count, options.seed_matches, threads);
+    }
+    if (options.check_batch_games > 0) return run_batch_check(options.check_batch_games);
+    if (options.ad_bench_rollouts > 0) return run_ad_benchmark(options.ad_bench_rollouts);
+    if (options.optimize_starts > 0) return run_trajectory_optimizer(options.optimize_starts, threads);
+    if (options.tournament_seeds > 0) {
+        return run_tournament(options.autopilot_paths, options.autopilot_count, options.tournament_seeds, threads);
+    }
+    if (options.replay_path) return run_replay(options.replay_path);
+    if (options.diff_paths[0]) return run_digest_diff(options.diff_paths[0], options.diff_paths[1]);
+    return run_game(&options);
+}
+
+// --- Command line ---
+
+static void print_help(void) {
+    printf("Moon Lander - Command Line Options:\n");
+    for (int o = 0; o < OPTION_COUNT; o++) printf("  %s\n", OPTION_SPECS[o].help);
+}
+
+// Returns -1 to go on, or the exit status once --help or a bad value ends
+// the run. Unknown arguments, and options missing their value, are ignored.
+int parse_options(int argc, char* argv[], Options* options) {
+    GameConfig config = DEFAULT_GAME_CONFIG;
+    LoadOptions load = {0, 1, 0.0, 10.0, NULL, 0, 0, 0, 0.0, 100.0, 0.0, 0, 0, NULL};
+    memset(options, 0, sizeof(*options));
+    options->config = config;
+    options->load = load;
+    options->n_envs = 64;
+    options->obs_layout = LANDER_OBS_F32;
+    options->difficulty = -1;
+    options->map_seeds = 8;
+    options->sweep_games = 2000;
+    options->calibrate_games = 1000000;
+    options->seed_matches = 10;
+
+    for (int i = 1; i < argc; i++) {
+        const OptionSpec* spec = NULL;
+        for (int o = 0; o < OPTION_COUNT && !spec; o++) {
+            if (strcmp(argv[i], OPTION_SPECS[o].name) == 0 ||
+                (OPTION_SPECS[o].alias && strcmp(argv[i], OPTION_SPECS[o].alias) == 0)) {
+                spec = &OPTION_SPECS[o];
+            }
+        }
+        if (!spec) continue;
+        int values = spec->kind == OPTION_FLAG || spec->kind == OPTION_HELP ? 0 : spec->kind == OPTION_PAIR ? 2 : 1;
+        if (i + values >= argc) continue;
+
+        char* field = (char*)options + spec->offset;
+        const char* value = values > 0 ? argv[++i] : NULL;
+        switch (spec->kind) {
+            case OPTION_FLAG: *(int*)field = 1; break;
+            case OPTION_INT: *(int*)field = atoi(value); break;
+            case OPTION_LONG: *(long long*)field = atoll(value); break;
+            case OPTION_DOUBLE: *(double*)field = atof(value); break;
+            case OPTION_STRING: *(const char**)field = value; break;
+
+            case OPTION_PAIR:
+                ((const char**)field)[0] = value;
+                ((const char**)field)[1] = argv[++i];
+                break;
+
+            case OPTION_OBS:
+                if (strcmp(value, "f32") == 0) *(int*)field = LANDER_OBS_F32;
+                else if (strcmp(value, "f16") == 0) *(int*)field = LANDER_OBS_F16;
+                else if (strcmp(value, "i8") == 0) *(int*)field = LANDER_OBS_I8;
+                else {
+                    printf("Error: Bad --obs layout '%s' (expected f32, f16 or i8).\n", value);
+                    return 1;
+                }
+                break;
+
+            case OPTION_VERSUS_HOST:
+            case OPTION_VERSUS_JOIN:
+                *(const char**)field = value;
+                options->versus_host = spec->kind == OPTION_VERSUS_HOST;
+                break;
+
+            case OPTION_AUTOPILOT:
+                if (options->autopilot_count < MAX_AUTOPILOTS) options->autopilot_paths[options->autopilot_count++] = value;
+                break;
+
+            case OPTION_FIND_SEED:
+                if (options->seed_predicate_count == MAX_SEED_PREDICATES ||
+                    parse_seed_predicate(value, &options->seed_predicates[options->seed_predicate_count]) != 0) {
+                    printf("Error: Bad --find-seed condition '%s' (expected FIELD OP VALUE).\n", value);
+                    return 1;
+                }
+                options->seed_predicate_count++;
+                break;
+
+            case OPTION_HELP:
+                print_help();
+                return 0;
+        }
+    }
+    return -1;
+}
+
+// --- Console game ---
+
+int run_game(Options* options) {
+    GameConfig* config = &options->config;
     GameState state;
     char command;
     int game_over = 1;
+    LanderCurriculum* curriculum = NULL;
+    uint32_t curriculum_rng = 1;
+    double difficulty = options->difficulty;
+    FILE* record = NULL;
+    uint64_t digest = 0;
+    RecoveryHistory* history;
+    SpectatorHub* spectators = NULL;
+    int started = 0;
 
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "--delta-v") == 0 || strcmp(argv[i], "-d") == 0) {
-            config.display_delta_v = 1;
-        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
-            printf("Moon Lander - Command Line Options:\n");
-            printf("  --delta-v, -d    Display velocity changes as Delta V\n");
-            printf("  --help, -h       Show this help message\n");
-            return 0;
+    srand(time(NULL));
+
+    history = recovery_create();
+    if (!history) {
+        printf("Error: Could not allocate the turn history.\n");
+        return 1;
+    }
+
+    if (options->record_path) {
+        record = fopen(options->record_path, "w");
+        if (!record) {
+            printf("Error: Could not open %s for recording.\n", options->record_path);
+            return 1;
         }
+        fprintf(record, "moon-lander-replay 1\n");
+        fprintf(record, "config %.17g %.17g %d %.17g %.17g %.17g\n", config->gravity, config->engine_force,
+                config->initial_fuel, config->safe_vertical_speed, config->safe_horizontal_speed,
+                config->terrain_penalty);
     }
 
-    srand(time(NULL));
+    if (options->spectate_host_path) {
+        spectators = spectator_hub_start(options->spectate_host_path);
+        if (!spectators) {
+            printf("Error: Could not host spectators on %s.\n", options->spectate_host_path);
+            return 1;
+        }
+        printf("Spectators can watch with: --spectate %s\n", options->spectate_host_path);
+    }
+
+    if (options->curriculum_path || difficulty >= 0) {
+        const char* path = options->curriculum_path;
+        if (path) curriculum = lander_curriculum_load(path);
+        if (!curriculum) {
+            int starts = options->curriculum_starts > 0 ? options->curriculum_starts : path ? 1000 : 256;
+            printf("Ranking %d starts by difficulty...\n", starts);
+            curriculum = lander_curriculum_build(starts, (uint32_t)rand(), options->threads);
+            if (curriculum && path) {
+                if (lander_curriculum_save(curriculum, path) == 0) {
+                    printf("Difficulty index saved to %s\n", path);
+                } else {
+                    printf("Error: Could not save difficulty index to %s.\n", path);
+                }
+            }
+        }
+        if (!curriculum) {
+            printf("Error: Could not build a difficulty index.\n");
+            return 1;
+        }
+        if (difficulty < 0) return 0; // Only asked to build the index
+        curriculum_rng = (uint32_t)rand() | 1u;
+    }
 
     printf("=== MOON LANDER WITH DYNAMIC RADAR VISUALS ===\n");
     printf("Olivetti Programma 101 Style Implementation\n");
     printf("Commands: V-Start, W-Engines On, S-Engines Off, Y-Left Burn, Z-Right Burn\n");
     printf("          X-Drift (skip burn), R-Activate Radar, C-Configure, Q-Quit\n");
-    printf("Display Mode: %s\n", config.display_delta_v ? "Delta V" : "m/s");
+    printf("Display Mode: %s\n", config->display_delta_v ? "Delta V" : "m/s");
     printf("\nNOTE: Use Radar (R) to activate the visual display, which zooms in on approach.\n");
     printf("Press 'V' to begin a new game.\n");
 
@@ -82,21 +432,39 @@ int main(int argc, char* argv[]) {
             continue;
         }
 
+        int in_game = !game_over && strchr("WSRXYZ", toupper(command)) != NULL;
+        uint32_t seed;
+
         switch (toupper(command)) {
             case 'V':
-                init_game(&state, &config);
+                seed = curriculum ? lander_curriculum_sample(curriculum, difficulty - 0.05, difficulty + 0.05, &curriculum_rng)
+                                  : (uint32_t)rand();
+                init_game_seeded(&state, config, seed);
+                recovery_reset(history);
+                started = 1;
+                digest = state_digest(&state, digest ^ seed);
+                if (record) fprintf(record, "game %u %016llx\n", seed, (unsigned long long)digest);
                 game_over = 0;
                 printf("\n=== NEW GAME STARTED ===\n");
-                display_status(&state, &config);
+                printf("Estimated difficulty: %.0f%% of your fuel\n", 100 * state.difficulty);
+                display_status(stdout, &state, config);
                 break;
 
             case 'C':
-                configure_game(&config);
+                configure_game(config);
+                if (record) {
+                    fprintf(record, "config %.17g %.17g %d %.17g %.17g %.17g\n", config->gravity, config->engine_force,
+                            config->initial_fuel, config->safe_vertical_speed, config->safe_horizontal_speed,
+                            config->terrain_penalty);
+                }
                 printf("\nConfiguration updated. Press 'V' to start a new game with these settings.\n");
                 break;
 
             case 'Q':
                 printf("Thanks for playing Moon Lander!\n");
+                if (record) fclose(record);
+                if (spectators) spectator_hub_stop(spectators);
+                recovery_destroy(history);
                 return 0;
 
             case 'W':
@@ -116,7 +484,7 @@ int main(int argc, char* argv[]) {
                 if (state.C > 0) {
                     activate_landing_radar(&state);
                     state.C--; // Radar consumes fuel
-                    display_status(&state, &config);
+                    display_status(stdout, &state, config);
                     if (state.C <= 0) printf("\n*** WARNING: FUEL DEPLETED. ***\n");
                 } else {
                     printf("No fuel remaining! Cannot activate radar.\n");
@@ -127,7 +495,7 @@ int main(int argc, char* argv[]) {
             case 'Z':
             case 'X':
                 if (!game_over) {
-                    handle_game_turn(&state, &config, toupper(command), &game_over);
+                    handle_game_turn(&state, config, history, toupper(command), &game_over);
                 }
                 break;
 
@@ -135,47 +503,64 @@ int main(int argc, char* argv[]) {
                 printf("Unknown command. Use: V, W, S, Y, Z, X, R, C, Q\n");
                 break;
         }
+
+        if (in_game) {
+            digest = state_digest(&state, digest);
+            if (record) {
+                fprintf(record, "%c %016llx\n", toupper(command), (unsigned long long)digest);
+                fflush(record);
+            }
+        }
+
+        if (spectators && started) {
+            // Rendered once per command, but only a changed frame is sent;
+            // every spectator gets the same buffer
+            static char frame[FRAME_BUFFER_SIZE], shown[FRAME_BUFFER_SIZE];
+            static long shown_length = -1;
+            FILE* out = fmemopen(frame, sizeof(frame), "w");
+            if (out) {
+                fprintf(out, "\033[H\033[2J");
+                display_status(out, &state, config);
+                if (game_over) fprintf(out, "\n*** %s ***\n", check_landing(&state, config) == 1 ? "LANDED" : "CRASHED");
+                long length = ftell(out);
+                fclose(out);
+                if (length != shown_length || memcmp(frame, shown, (size_t)length) != 0) {
+                    memcpy(shown, frame, (size_t)length);
+                    shown_length = length;
+                    spectator_publish(spectators, frame, (size_t)length);
+                }
+            }
+        }
     }
     return 0;
 }
 
-void handle_game_turn(GameState* state, GameConfig* config, char command, int* game_over) {
-    if (state->C <= 0) {
-        printf("No fuel remaining! Lander is now drifting.\n");
-        state->engines_on = 0;
-        command = 'X'; // Force drift if out of fuel
-    }
+void handle_game_turn(GameState* state, GameConfig* config, RecoveryHistory* history, char command, int* game_over) {
+    GameState before = *state;
+    if (state->C <= 0) printf("No fuel remaining! Lander is now drifting.\n");
 
-    if ((command == 'Y' || command == 'Z') && !state->engines_on) {
+    int landing_result = simulate_turn(state, config, command);
+    if (landing_result == TURN_REJECTED) {
         printf("Cannot burn. Main engines are OFF (use 'W' to turn on).\n");
         return; // Not a full turn, so return early
     }
+    recovery_record(history, &before, before.C > 0 ? command : 'X');
 
-    if (state->radar.active && state->radar.turns_remaining > 0) {
+    if (before.radar.active && before.radar.turns_remaining > 0) {
         printf("\n[Radar data from previous position]\n");
-        display_landing_radar(state);
-    }
-
-    update_physics(state, config, command);
-    if (command != 'X') state->C--;
-
-    if (state->radar.active && state->radar.turns_remaining > 0) {
-        state->radar.turns_remaining--;
-        if (state->radar.turns_remaining <= 0) {
-            state->radar.active = 0;
-            printf(">>> Landing radar signal lost. Visuals deactivated. <<<\n");
-        }
+        display_landing_radar(&before);
+        if (!state->radar.active) printf(">>> Landing radar signal lost. Visuals deactivated. <<<\n");
     }
 
-    display_status(state, config);
+    display_status(stdout, state, config);
 
-    int landing_result = check_landing(state);
     if (landing_result != 0) {
         if (landing_result == 1) {
             printf("\n*** THE EAGLE HAS LANDED! SUCCESSFUL LANDING! ***\n");
             save_result(state, "SUCCESS");
         } else {
             printf("\n*** CRASHED! High impact speed. ***\n");
+            report_point_of_no_return(history, config);
             save_result(state, "CRASHED");
         }
         *game_over = 1;
@@ -184,55 +569,6 @@ void handle_game_turn(GameState* state, GameConfig* config, char command, int* g
     }
 }
 
-void init_game(GameState* state, GameConfig* config) {
-    state->A = (double)(rand() % 200 - 100);
-    state->B = (double)(rand() % 500 + 100);
-    state->vel_h = (double)(rand() % 20 - 10) / 2.0;
-    state->vel_v = (double)(rand() % 20 - 15);
-    state->prev_vel_h = state->vel_h;
-    state->prev_vel_v = state->vel_v;
-    state->C = config->initial_fuel;
-    state->engines_on = 0;
-    state->time_step = 1.0;
-    state->radar.active = 0;
-    state->radar.turns_remaining = 0;
-    generate_terrain_data(state);
-}
-
-void generate_terrain_data(GameState* state) {
-    for (int i = 0; i < 21; i++) {
-        double x_pos = -100 + (i * 10);
-        double base_height = 0.0;
-        double variation = sin(x_pos * 0.1) * 5 + cos(x_pos * 0.05) * 3;
-        double hazard = (rand() % 100 < 15) ? (rand() % 20 - 10) * 0.5 : 0.0;
-        state->radar.terrain_height[i] = base_height + variation + hazard;
-    }
-
-    double best_safety = -1, best_x = 0;
-    for (int i = 1; i < 20; i++) {
-        double x_pos = -100 + (i * 10);
-        double safety = calculate_landing_safety(state, x_pos);
-        if (safety > best_safety) {
-            best_safety = safety;
-            best_x = x_pos;
-        }
-    }
-    state->radar.safe_landing_x = best_x;
-    state->radar.safe_landing_score = best_safety;
-}
-
-double calculate_landing_safety(GameState* state, double x_pos) {
-    int index = (int)((x_pos + 100) / 10);
-    if (index < 0 || index >= 21) return 0;
-    double safety = 100.0;
-    safety -= fabs(state->radar.terrain_height[index]) * 10;
-    if (index > 0 && index < 20) {
-        double slope_left = fabs(state->radar.terrain_height[index] - state->radar.terrain_height[index - 1]);
-        double slope_right = fabs(state->radar.terrain_height[index + 1] - state->radar.terrain_height[index]);
-        safety -= (slope_left + slope_right) * 5;
-    }
-    return fmax(0, safety);
-}
 
 void activate_landing_radar(GameState* state) {
     printf("\n=== ACTIVATING LANDING RADAR (1 fuel consumed) ===\n");
@@ -254,99 +590,6 @@ void display_landing_radar(GameState* state) {
     printf("-----------------------------------------------\n");
 }
 
-void display_visualizer(GameState* state) {
-    const int VIS_WIDTH = 61;
-    const int VIS_HEIGHT = 16;
-    const double WORLD_X_MIN = -100.0, WORLD_X_MAX = 100.0;
-
-    double world_view_height_m;
-    double world_y_min;
-
-    if (state->B < 60.0) { // Low altitude: "Landing Mode"
-        world_view_height_m = 40.0;
-        world_y_min = -15.0;
-    } else { // High altitude: "Approach Mode"
-        world_view_height_m = 150.0;
-        double world_y_max = state->B + 30.0;
-        world_y_min = world_y_max - world_view_height_m;
-    }
-
-    char canvas[VIS_HEIGHT][VIS_WIDTH + 1];
-    memset(canvas, ' ', sizeof(canvas));
-    for (int i = 0; i < VIS_HEIGHT; i++) canvas[i][VIS_WIDTH] = '\0';
-
-    double prev_terrain_h = 0.0;
-    for (int x = 0; x < VIS_WIDTH; x++) {
-        double world_x = WORLD_X_MIN + (x / (double)(VIS_WIDTH - 1)) * (WORLD_X_MAX - WORLD_X_MIN);
-        double pos_in_array = (world_x - WORLD_X_MIN) / 10.0;
-        int index1 = fmax(0, fmin(20, (int)floor(pos_in_array)));
-        int index2 = fmax(0, fmin(20, (int)ceil(pos_in_array)));
-
-        // Interpolation for nicer visual
-        double terrain_h = (index1 == index2) ? state->radar.terrain_height[index1] : state->radar.terrain_height[index1] + (state->radar.terrain_height[index2] - state->radar.terrain_height[index1]) * (pos_in_array - index1);
-
-        int canvas_y = (VIS_HEIGHT - 1) - (int)round(((terrain_h - world_y_min) / world_view_height_m) * (VIS_HEIGHT - 1));
-
-        if (canvas_y >= 0 && canvas_y < VIS_HEIGHT) {
-            char terrain_char = '_';
-            if (x > 0) {
-                if (terrain_h > prev_terrain_h + 0.5) terrain_char = '/';
-                if (terrain_h < prev_terrain_h - 0.5) terrain_char = '\\';
-            }
-            prev_terrain_h = terrain_h;
-            canvas[canvas_y][x] = terrain_char;
-            for (int fill_y = canvas_y + 1; fill_y < VIS_HEIGHT; fill_y++) canvas[fill_y][x] = '#';
-        }
-    }
-
-    int lander_x = (int)round(((state->A - WORLD_X_MIN) / (WORLD_X_MAX - WORLD_X_MIN)) * (VIS_WIDTH - 1));
-    int lander_y = (VIS_HEIGHT - 1) - (int)round(((state->B - world_y_min) / world_view_height_m) * (VIS_HEIGHT - 1));
-
-    if (lander_y >= 0 && lander_y < VIS_HEIGHT && lander_x >= 0 && lander_x < VIS_WIDTH) {
-        if (canvas[lander_y][lander_x] == ' ') canvas[lander_y][lander_x] = 'A';
-        if (state->engines_on && lander_y < VIS_HEIGHT - 1 && canvas[lander_y + 1][lander_x] == ' ') {
-            canvas[lander_y + 1][lander_x] = '*';
-        }
-    }
-
-    printf("\n.---[ RADAR VISUALS ]-----------------------------------------------.\n");
-    for (int i = 0; i < VIS_HEIGHT; i++) {
-        printf("| %s | %+.0fm\n", canvas[i], (world_y_min + world_view_height_m) - (i / (double)(VIS_HEIGHT - 1) * world_view_height_m));
-    }
-    printf("`------------------------------------------------------------------´\n");
-    printf("  %-30s 0m %28s\n", "-100m", "+100m");
-}
-
-void display_status(GameState* state, GameConfig* config) {
-    if (state->radar.active) {
-        display_visualizer(state);
-    }
-
-    printf("\n--- LANDER STATUS ---\n");
-    printf("A (X pos): %8.1f m\n", state->A);
-    printf("B (Alt):   %8.1f m\n", state->B);
-
-    if (config->display_delta_v) {
-        double delta_h = state->vel_h - state->prev_vel_h;
-        double delta_v = state->vel_v - state->prev_vel_v;
-        printf("ΔV H:      %8.1f m/s\n", delta_h);
-        printf("ΔV V:      %8.1f m/s\n", delta_v);
-    } else {
-        printf("Vel H:     %8.1f m/s  %s\n", state->vel_h, state->vel_h > 0 ? "->" : "<-");
-        printf("Vel V:     %8.1f m/s  %s\n", state->vel_v, state->vel_v < 0 ? "v (Down)" : "^ (Up)");
-    }
-
-    printf("C (Fuel):  %8d burns\n", state->C);
-    printf("Engines:   %s\n", state->engines_on ? "ON" : "OFF");
-
-    if (state->radar.active) {
-        printf("Radar:     ACTIVE (%d turns remaining)\n", state->radar.turns_remaining);
-    } else {
-        printf("Radar:     INACTIVE (use 'R' for visuals)\n");
-    }
-    printf("---------------------\n");
-}
-
 char get_command(void) {
     char command;
     printf("\nCommand: ");
@@ -355,52 +598,6 @@ char get_command(void) {
     return command;
 }
 
-void update_physics(GameState* state, GameConfig* config, char move_command) {
-    double dt = state->time_step;
-    state->prev_vel_h = state->vel_h;
-    state->prev_vel_v = state->vel_v;
-
-    state->vel_v -= config->gravity * dt;
-
-    if (state->engines_on) {
-        if (move_command == 'Y') {
-            state->vel_v += config->engine_force * dt;
-            state->vel_h += config->engine_force * dt * 0.3;
-        } else if (move_command == 'Z') {
-            state->vel_v += config->engine_force * dt;
-            state->vel_h -= config->engine_force * dt * 0.3;
-        }
-    }
-
-    state->A += state->vel_h * dt;
-    state->B += state->vel_v * dt;
-
-    if (state->B < 0) state->B = 0;
-}
-
-int check_landing(GameState* state) {
-    const double SAFE_VERTICAL_SPEED = 2.0;
-    const double SAFE_HORIZONTAL_SPEED = 1.5;
-
-    if (state->B <= 0) {
-        double terrain_penalty = 0;
-        if (state->A >= -100 && state->A <= 100) {
-            int index = (int)((state->A + 100) / 10.0);
-            if (index < 0) index = 0;
-            if (index > 20) index = 20;
-            terrain_penalty = fabs(state->radar.terrain_height[index]) * 0.2;
-        }
-
-        if (fabs(state->vel_v) < (SAFE_VERTICAL_SPEED - terrain_penalty) &&
-            fabs(state->vel_h) < (SAFE_HORIZONTAL_SPEED - terrain_penalty)) {
-            return 1; // Success
-        } else {
-            return -1; // Crash
-        }
-    }
-    return 0; // Still flying
-}
-
 void save_result(GameState* state, const char* result) {
     FILE* fp = fopen("lander_results.txt", "a");
     if (fp) {
@@ -425,14 +622,17 @@ void save_result(GameState* state, const char* result) {
 
 void configure_game(GameConfig* config) {
     int choice = 0;
-    while (choice != 5) {
+    while (choice != 8) {
         printf("\n=== GAME CONFIGURATION ===\n");
         printf("1. Gravity:       %.2f m/s²\n", config->gravity);
         printf("2. Engine Force:  %.2f m/s²\n", config->engine_force);
         printf("3. Initial Fuel:  %d burns\n", config->initial_fuel);
         printf("4. Display Mode:  %s\n", config->display_delta_v ? "Delta V" : "m/s");
-        printf("5. Return to game\n");
-        printf("Choose setting to change (1-5): ");
+        printf("5. Safe Vertical Speed:   %.2f m/s\n", config->safe_vertical_speed);
+        printf("6. Safe Horizontal Speed: %.2f m/s\n", config->safe_horizontal_speed);
+        printf("7. Terrain Penalty:       %.2f m/s per unit of height\n", config->terrain_penalty);
+        printf("8. Return to game\n");
+        printf("Choose setting to change (1-8): ");
 
         if (scanf("%d", &choice) != 1) choice = 0;
         while (getchar() != '\n'); // Clear input buffer
@@ -455,12 +655,822 @@ void configure_game(GameConfig* config) {
                 printf("Display mode set to %s\n", config->display_delta_v ? "Delta V" : "m/s");
                 break;
             case 5:
+                printf("Enter new safe vertical speed (m/s): ");
+                scanf("%lf", &config->safe_vertical_speed);
+                break;
+            case 6:
+                printf("Enter new safe horizontal speed (m/s): ");
+                scanf("%lf", &config->safe_horizontal_speed);
+                break;
+            case 7:
+                printf("Enter new terrain penalty factor: ");
+                scanf("%lf", &config->terrain_penalty);
+                break;
+            case 8:
                 printf("Returning to main menu...\n");
                 break;
             default:
                 printf("Invalid choice.\n");
                 break;
         }
-        if (choice > 0 && choice < 5) while (getchar() != '\n');
+        if (choice > 0 && choice < 8) while (getchar() != '\n');
+    }
+}
+
+// --- Point of no return ---
+
+#define RECOVERY_BUDGET_NS 100000000ull // Answer within 100 ms of the crash
+
+RecoveryHistory* recovery_create(void) {
+    return calloc(1, sizeof(RecoveryHistory));
+}
+
+void recovery_destroy(RecoveryHistory* history) {
+    if (!history) return;
+    if (history->workspace_ready) solver_free(&history->workspace);
+    free(history);
+}
+
+void recovery_reset(RecoveryHistory* history) {
+    history->turns = 0;
+}
+
+void recovery_record(RecoveryHistory* history, GameState* state, char command) {
+    history->states[history->turns % RECOVERY_HISTORY] = *state;
+    history->commands[history->turns % RECOVERY_HISTORY] = command;
+    history->turns++;
+}
+
+// Walks the crashed game backwards from the last turn and reports the latest
+// turn from which the solver still finds a safe landing
+void report_point_of_no_return(RecoveryHistory* history, GameConfig* config) {
+    if (!history->workspace_ready) {
+        if (solver_init(&history->workspace, SOLVER_DEFAULT_BEAM) != 0) return;
+        history->workspace_ready = 1;
+    }
+
+    uint64_t deadline = now_ns() + RECOVERY_BUDGET_NS;
+    int turns = history->turns;
+    int oldest = turns > RECOVERY_HISTORY ? turns - RECOVERY_HISTORY : 0;
+    for (int turn = turns - 1; turn >= oldest; turn--) {
+        GameState* state = &history->states[turn % RECOVERY_HISTORY];
+        SolverResult result;
+        solve_landing(&history->workspace, state, config, &result);
+        if (result.min_fuel >= 0 && result.min_fuel <= state->C) {
+            // The solver assumes the engines are on; only a burn needs them
+            int needs_engines = !state->engines_on && result.first_command != 'X';
+            char played = history->commands[turn % RECOVERY_HISTORY];
+            printf("Point of no return: turn %d of %d, at %.0f m altitude.\n", turn + 1, turns, state->B);
+            printf("  You played '%c'; %s'%c' would still have landed, needing %d of your %d burns.\n", played,
+                   needs_engines ? "'W' then " : "", result.first_command, result.min_fuel, state->C);
+            return;
+        }
+        if (now_ns() > deadline) {
+            printf("Point of no return: before turn %d (search stopped after %d turns).\n", turn + 1, turns - turn);
+            return;
+        }
+    }
+    printf("Point of no return: none found; no safe landing was reachable from turn %d%s.\n", oldest + 1,
+           oldest > 0 ? " (the earliest turn kept)" : "");
+}
+
+// --- Head-to-head lockstep with rollback ---
+
+#define VERSUS_HISTORY 16 // Ticks of snapshots kept; prediction never runs further ahead
+
+// Both landers; players[0] is the host
+typedef struct {
+    Session players[2];
+} VersusState;
+
+typedef struct {
+    uint32_t tick;
+    char command;
+    char padding[3];
+    uint64_t digest; // Sender's own session digest after this tick
+} VersusMessage;
+
+// Sent by both sides on connect; the joiner takes the host's seed
+typedef struct {
+    uint32_t seed;
+    uint32_t padding;
+    uint64_t config; // config_digest
+} VersusHello;
+
+typedef struct {
+    int fd;
+    int local;
+    uint32_t tick; // Next tick to simulate
+    uint32_t confirmed; // Remote inputs are known for ticks < confirmed
+    char local_input[VERSUS_HISTORY];
+    char remote_input[VERSUS_HISTORY]; // Confirmed, or the prediction used
+    uint64_t remote_digest[VERSUS_HISTORY]; // Opponent's digest after each confirmed tick
+    uint32_t desync_tick; // First tick whose digests differed, plus one; 0 = none
+    VersusState snapshots[VERSUS_HISTORY]; // State before each tick
+    VersusState current;
+    char last_remote;
+    int rollbacks, max_resimulated;
+    uint64_t max_rollback_ns;
+    VersusMessage pending;
+    size_t pending_bytes;
+} VersusMatch;
+
+static char versus_predict(VersusMatch* match) {
+    // Burns and drifts tend to repeat; toggles and radar are one-offs
+    return strchr("XYZ", match->last_remote) ? match->last_remote : 'X';
+}
+
+// The opponent's lander depends only on its own confirmed inputs, so after a
+// confirmed tick it must match the digest the opponent sent for that tick
+static void versus_check(VersusMatch* match, uint32_t tick, Session* opponent) {
+    if (match->desync_tick || opponent->digest == match->remote_digest[tick % VERSUS_HISTORY]) return;
+    match->desync_tick = tick + 1;
+    printf("[Desync: the opponent's lander differs from ours after turn %u]\n", tick + 1);
+}
+
+static void versus_apply_tick(VersusMatch* match, uint32_t tick) {
+    int slot = tick % VERSUS_HISTORY;
+    match->snapshots[slot] = match->current;
+    char commands[2];
+    commands[match->local] = match->local_input[slot];
+    commands[1 - match->local] = match->remote_input[slot];
+    for (int p = 0; p < 2; p++) {
+        if (!match->current.players[p].game_over) session_command(&match->current.players[p], commands[p]);
+    }
+    if (tick < match->confirmed) versus_check(match, tick, &match->current.players[1 - match->local]);
+}
+
+// Returns -1 for a message out of sequence: the stream carries every tick
+// once, in order
+static int versus_confirm(VersusMatch* match, VersusMessage* message) {
+    uint32_t tick = ntohl(message->tick);
+    int slot = tick % VERSUS_HISTORY;
+    char predicted = match->remote_input[slot];
+    if (tick != match->confirmed) {
+        printf("Error: The opponent sent turn %u, expected %u.\n", tick + 1, match->confirmed + 1);
+        return -1;
+    }
+
+    match->remote_input[slot] = message->command;
+    match->remote_digest[slot] = be64toh(message->digest);
+    match->last_remote = message->command;
+    match->confirmed = tick + 1;
+    if (tick >= match->tick) return 0; // Checked when we reach it
+    if (predicted == message->command) {
+        VersusState* after = tick + 1 < match->tick ? &match->snapshots[(tick + 1) % VERSUS_HISTORY] : &match->current;
+        versus_check(match, tick, &after->players[1 - match->local]);
+        return 0;
+    }
+
+    // Misprediction: restore the snapshot and re-simulate up to the present
+    uint64_t start = now_ns();
+    match->current = match->snapshots[slot];
+    for (uint32_t t = tick; t < match->tick; t++) {
+        if (t > tick) match->remote_input[t % VERSUS_HISTORY] = versus_predict(match);
+        versus_apply_tick(match, t);
+    }
+    uint64_t cost = now_ns() - start;
+
+    int resimulated = (int)(match->tick - tick);
+    match->rollbacks++;
+    if (resimulated > match->max_resimulated) match->max_resimulated = resimulated;
+    if (cost > match->max_rollback_ns) match->max_rollback_ns = cost;
+    printf("[Rollback: opponent played %c, not %c; re-simulated %d turns in %.1f us]\n",
+           message->command, predicted, resimulated, cost / 1e3);
+    return 0;
+}
+
+// Drains the socket; blocks until at least one message when `wait` is set.
+// Returns -1 once the opponent has gone or broken the sequence.
+static int versus_receive(VersusMatch* match, int wait) {
+    for (;;) {
+        struct pollfd pfd = {match->fd, POLLIN, 0};
+        if (poll(&pfd, 1, wait ? -1 : 0) <= 0) return 0;
+
+        ssize_t n = recv(match->fd, (char*)&match->pending + match->pending_bytes,
+                         sizeof(VersusMessage) - match->pending_bytes, 0);
+        if (n <= 0) return -1;
+        match->pending_bytes += (size_t)n;
+        if (match->pending_bytes == sizeof(VersusMessage)) {
+            match->pending_bytes = 0;
+            if (versus_confirm(match, &match->pending) != 0) return -1;
+            wait = 0;
+        }
+    }
+}
+
+static int versus_send(VersusMatch* match, uint32_t tick, char command, uint64_t digest) {
+    VersusMessage message = {htonl(tick), command, {0}, htobe64(digest)};
+    return send(match->fd, &message, sizeof(message), MSG_NOSIGNAL) == (ssize_t)sizeof(message) ? 0 : -1;
+}
+
+// Returns the connected socket, -1 on failure or -2 when the two sides'
+// configs differ
+static int versus_connect(const char* socket_path, int host, uint32_t* seed, GameConfig* config) {
+    VersusHello mine = {htonl(*seed), 0, htobe64(config_digest(config))}, theirs;
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    if (host) {
+        unlink(socket_path);
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0) {
+            close(fd);
+            return -1;
+        }
+        printf("Waiting for an opponent on %s...\n", socket_path);
+        int peer = accept(fd, NULL, NULL);
+        close(fd);
+        unlink(socket_path);
+        fd = peer;
+    } else if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    if (fd < 0 || send(fd, &mine, sizeof(mine), MSG_NOSIGNAL) != (ssize_t)sizeof(mine) ||
+        recv(fd, &theirs, sizeof(theirs), MSG_WAITALL) != (ssize_t)sizeof(theirs)) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    if (theirs.config != mine.config) {
+        close(fd);
+        return -2;
+    }
+    if (!host) *seed = ntohl(theirs.seed);
+    return fd;
+}
+
+static void versus_show(VersusMatch* match, GameConfig* config) {
+    Session* me = &match->current.players[match->local];
+    Session* opponent = &match->current.players[1 - match->local];
+    display_status(stdout, &me->state, config);
+    printf("Opponent:  A=%.1f m  B=%.1f m  Fuel=%d  %s%s\n", opponent->state.A, opponent->state.B,
+           opponent->state.C, opponent->game_over ? "DOWN" : "FLYING",
+           match->confirmed < match->tick ? "  (predicted)" : "");
+}
+
+int run_versus(const char* socket_path, int host, GameConfig* config) {
+    static VersusMatch match; // Snapshots make this too big for the stack
+    uint32_t seed = (uint32_t)time(NULL);
+
+    memset(&match, 0, sizeof(match));
+    match.local = host ? 0 : 1;
+    match.last_remote = 'X';
+    match.fd = versus_connect(socket_path, host, &seed, config);
+    if (match.fd == -2) {
+        printf("Error: The opponent plays with a different game config (gravity, engine force, fuel or touchdown limits).\n");
+        return 1;
+    }
+    if (match.fd < 0) {
+        printf("Error: Could not %s a head-to-head game on %s.\n", host ? "host" : "join", socket_path);
+        return 1;
+    }
+
+    for (int p = 0; p < 2; p++) {
+        init_session(&match.current.players[p], config, 1);
+        session_start(&match.current.players[p], seed); // Same terrain and start for both
+    }
+
+    printf("\n=== HEAD-TO-HEAD GAME STARTED (you are player %d) ===\n", match.local + 1);
+    printf("Commands: W, S, Y, Z, X, R as usual; first safe landing with the most fuel wins. Q quits.\n");
+    versus_show(&match, config);
+
+    for (;;) {
+        if (versus_receive(&match, 0) < 0) break;
+        Session* me = &match.current.players[match.local];
+        int both_down = me->game_over && match.current.players[1 - match.local].game_over;
+        if (both_down && match.confirmed == match.tick) break;
+
+        // Don't let prediction outrun the snapshot history, and once our own
+        // lander is down there is nothing to predict for
+        int behind = match.confirmed < match.tick ? (int)(match.tick - match.confirmed) : 0;
+        if (behind >= VERSUS_HISTORY - 1 || (me->game_over && behind > 0)) {
+            if (versus_receive(&match, 1) < 0) break;
+            continue;
+        }
+
+        char command = 'X';
+        if (!me->game_over) {
+            command = (char)toupper(get_command());
+            if (command == 'Q') break;
+            if (!strchr("WSRXYZ", command)) {
+                printf("Unknown command. Use: W, S, Y, Z, X, R, Q\n");
+                continue;
+            }
+        }
+
+        int slot = match.tick % VERSUS_HISTORY;
+        match.local_input[slot] = command;
+        if (match.confirmed <= match.tick) match.remote_input[slot] = versus_predict(&match); // Else already known
+        versus_apply_tick(&match, match.tick);
+        if (versus_send(&match, match.tick, command, me->digest) != 0) break;
+        match.tick++;
+
+        if (versus_receive(&match, 0) < 0) break;
+        if (!me->game_over || command != 'X') versus_show(&match, config);
+    }
+    close(match.fd);
+
+    int result[2];
+    for (int p = 0; p < 2; p++) {
+        Session* player = &match.current.players[p];
+        result[p] = player->game_over ? check_landing(&player->state, &player->config) : 0;
+    }
+    int me = match.local, opponent = 1 - match.local;
+    printf("\n=== HEAD-TO-HEAD RESULT ===\n");
+    printf("You:      %s, %d fuel left\n", result[me] == 1 ? "LANDED" : result[me] == -1 ? "CRASHED" : "UNFINISHED",
+           match.current.players[me].state.C);
+    printf("Opponent: %s, %d fuel left\n", result[opponent] == 1 ? "LANDED" : result[opponent] == -1 ? "CRASHED" : "UNFINISHED",
+           match.current.players[opponent].state.C);
+
+    int score_me = result[me] == 1 ? 1000 + match.current.players[me].state.C : 0;
+    int score_opponent = result[opponent] == 1 ? 1000 + match.current.players[opponent].state.C : 0;
+    printf("%s\n", score_me > score_opponent ? "*** YOU WIN! ***" : score_me < score_opponent ? "*** YOU LOSE. ***" : "*** DRAW. ***");
+    printf("Rollbacks: %d (longest %d turns, worst %.1f us)\n", match.rollbacks, match.max_resimulated,
+           match.max_rollback_ns / 1e3);
+    if (match.desync_tick) {
+        printf("Warning: The two games diverged after turn %u; the other screen may show a different result.\n",
+               match.desync_tick);
+    }
+    return 0;
+}
+
+// --- Spectator fan-out ---
+
+#define SPECTATOR_MAX 1024
+
+// One rendered frame, shared by every spectator queue that holds it
+typedef struct {
+    int refs;
+    size_t length;
+    char data[];
+} SpectatorFrame;
+
+// Each spectator finishes the frame it is writing and keeps only the newest
+// one behind it; anything older is stale and dropped
+typedef struct {
+    int fd;
+    SpectatorFrame* sending;
+    size_t offset;
+    SpectatorFrame* pending;
+} Spectator;
+
+struct SpectatorHub {
+    int listen_fd;
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)]; // Unlinked on stop
+    int wake[2];
+    pthread_t thread;
+    pthread_mutex_t lock;
+    SpectatorFrame* latest; // Guarded by lock
+    int stop;               // Guarded by lock
+    Spectator spectators[SPECTATOR_MAX];
+    int count;
+    uint64_t frames;
+    uint64_t dropped;
+    uint64_t peak;
+};
+
+static void frame_retain(SpectatorFrame* frame) {
+    __atomic_add_fetch(&frame->refs, 1, __ATOMIC_RELAXED);
+}
+
+static void frame_release(SpectatorFrame* frame) {
+    if (frame && __atomic_sub_fetch(&frame->refs, 1, __ATOMIC_ACQ_REL) == 0) free(frame);
+}
+
+static void spectator_offer(SpectatorHub* hub, Spectator* spectator, SpectatorFrame* frame) {
+    if (spectator->pending) {
+        frame_release(spectator->pending);
+        hub->dropped++;
+    }
+    frame_retain(frame);
+    spectator->pending = frame;
+}
+
+// Returns -1 if the spectator has gone away
+static int spectator_flush(Spectator* spectator) {
+    while (spectator->sending || spectator->pending) {
+        if (!spectator->sending) {
+            spectator->sending = spectator->pending;
+            spectator->pending = NULL;
+            spectator->offset = 0;
+        }
+
+        struct iovec iov[2];
+        int parts = 0;
+        iov[parts].iov_base = spectator->sending->data + spectator->offset;
+        iov[parts++].iov_len = spectator->sending->length - spectator->offset;
+        if (spectator->pending) {
+            iov[parts].iov_base = spectator->pending->data;
+            iov[parts++].iov_len = spectator->pending->length;
+        }
+
+        ssize_t written = writev(spectator->fd, iov, parts);
+        if (written < 0) return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+
+        spectator->offset += (size_t)written;
+        while (spectator->sending && spectator->offset >= spectator->sending->length) {
+            spectator->offset -= spectator->sending->length;
+            frame_release(spectator->sending);
+            spectator->sending = spectator->pending;
+            spectator->pending = NULL;
+        }
+    }
+    return 0;
+}
+
+static void spectator_remove(SpectatorHub* hub, int index) {
+    Spectator* spectator = &hub->spectators[index];
+    close(spectator->fd);
+    frame_release(spectator->sending);
+    frame_release(spectator->pending);
+    hub->spectators[index] = hub->spectators[--hub->count];
+}
+
+static void* spectator_hub_main(void* arg) {
+    SpectatorHub* hub = arg;
+    static struct pollfd fds[SPECTATOR_MAX + 2]; // Only one hub per process
+
+    for (;;) {
+        fds[0].fd = hub->wake[0];
+        fds[0].events = POLLIN;
+        fds[1].fd = hub->listen_fd;
+        fds[1].events = hub->count < SPECTATOR_MAX ? POLLIN : 0;
+        for (int i = 0; i < hub->count; i++) {
+            Spectator* spectator = &hub->spectators[i];
+            fds[i + 2].fd = spectator->fd;
+            fds[i + 2].events = POLLIN | (spectator->sending || spectator->pending ? POLLOUT : 0);
+            fds[i + 2].revents = 0;
+        }
+        int polled = hub->count;
+        if (poll(fds, (nfds_t)polled + 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        // Spectators never send anything, so readable means hung up
+        for (int i = polled - 1; i >= 0; i--) {
+            short revents = fds[i + 2].revents;
+            if ((revents & (POLLIN | POLLERR | POLLHUP)) ||
+                ((revents & POLLOUT) && spectator_flush(&hub->spectators[i]) != 0)) {
+                spectator_remove(hub, i);
+            }
+        }
+
+        SpectatorFrame* latest = NULL;
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            while (read(hub->wake[0], drain, sizeof(drain)) > 0) {
+            }
+            pthread_mutex_lock(&hub->lock);
+            if (hub->stop) {
+                pthread_mutex_unlock(&hub->lock);
+                break;
+            }
+            latest = hub->latest;
+            if (latest) frame_retain(latest);
+            pthread_mutex_unlock(&hub->lock);
+
+            if (latest) {
+                for (int i = hub->count - 1; i >= 0; i--) {
+                    spectator_offer(hub, &hub->spectators[i], latest);
+                    if (spectator_flush(&hub->spectators[i]) != 0) spectator_remove(hub, i);
+                }
+                hub->frames++;
+            }
+        }
+
+        if (fds[1].revents & POLLIN) {
+            int fd;
+            while (hub->count < SPECTATOR_MAX && (fd = accept(hub->listen_fd, NULL, NULL)) >= 0) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                Spectator* spectator = &hub->spectators[hub->count++];
+                memset(spectator, 0, sizeof(*spectator));
+                spectator->fd = fd;
+
+                // Newcomers start from the current frame
+                if (!latest) {
+                    pthread_mutex_lock(&hub->lock);
+                    latest = hub->latest;
+                    if (latest) frame_retain(latest);
+                    pthread_mutex_unlock(&hub->lock);
+                }
+                if (latest) {
+                    spectator_offer(hub, spectator, latest);
+                    if (spectator_flush(spectator) != 0) spectator_remove(hub, hub->count - 1);
+                }
+            }
+            if (hub->peak < (uint64_t)hub->count) hub->peak = (uint64_t)hub->count;
+        }
+        frame_release(latest);
+    }
+
+    while (hub->count > 0) spectator_remove(hub, hub->count - 1);
+    return NULL;
+}
+
+SpectatorHub* spectator_hub_start(const char* socket_path) {
+    SpectatorHub* hub = calloc(1, sizeof(SpectatorHub));
+    struct sockaddr_un addr;
+    if (!hub) return NULL;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    memcpy(hub->path, addr.sun_path, sizeof(hub->path));
+    hub->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if (hub->listen_fd < 0 || bind(hub->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(hub->listen_fd, 64) != 0 || pipe(hub->wake) != 0) {
+        if (hub->listen_fd >= 0) close(hub->listen_fd);
+        unlink(socket_path);
+        free(hub);
+        return NULL;
+    }
+    fcntl(hub->listen_fd, F_SETFL, fcntl(hub->listen_fd, F_GETFL) | O_NONBLOCK);
+    fcntl(hub->wake[0], F_SETFL, fcntl(hub->wake[0], F_GETFL) | O_NONBLOCK);
+    fcntl(hub->wake[1], F_SETFL, fcntl(hub->wake[1], F_GETFL) | O_NONBLOCK);
+    signal(SIGPIPE, SIG_IGN); // A spectator closing mid-frame must not kill the game
+    pthread_mutex_init(&hub->lock, NULL);
+
+    if (pthread_create(&hub->thread, NULL, spectator_hub_main, hub) != 0) {
+        close(hub->listen_fd);
+        unlink(socket_path);
+        close(hub->wake[0]);
+        close(hub->wake[1]);
+        free(hub);
+        return NULL;
+    }
+    return hub;
+}
+
+void spectator_publish(SpectatorHub* hub, const char* data, size_t length) {
+    SpectatorFrame* frame = malloc(sizeof(SpectatorFrame) + length);
+    if (!frame) return;
+    frame->refs = 1; // Held by hub->latest
+    frame->length = length;
+    memcpy(frame->data, data, length);
+
+    pthread_mutex_lock(&hub->lock);
+    SpectatorFrame* previous = hub->latest;
+    hub->latest = frame;
+    pthread_mutex_unlock(&hub->lock);
+    frame_release(previous);
+
+    char wake = 1;
+    if (write(hub->wake[1], &wake, 1) < 0) {
+        // Pipe already full: the hub is due to wake anyway
+    }
+}
+
+void spectator_hub_stop(SpectatorHub* hub) {
+    char wake = 1;
+    pthread_mutex_lock(&hub->lock);
+    hub->stop = 1;
+    pthread_mutex_unlock(&hub->lock);
+    if (write(hub->wake[1], &wake, 1) < 0) {
     }
+    pthread_join(hub->thread, NULL);
+
+    printf("Spectators: %llu frames broadcast, %llu stale frames dropped, peak %llu watching\n",
+           (unsigned long long)hub->frames, (unsigned long long)hub->dropped, (unsigned long long)hub->peak);
+    close(hub->listen_fd);
+    unlink(hub->path);
+    close(hub->wake[0]);
+    close(hub->wake[1]);
+    frame_release(hub->latest);
+    pthread_mutex_destroy(&hub->lock);
+    free(hub);
 }
+
+int run_spectate(const char* socket_path) {
+    struct sockaddr_un addr;
+    char buffer[FRAME_BUFFER_SIZE];
+    ssize_t received;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        printf("Error: No game to watch on %s.\n", socket_path);
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    while ((received = read(fd, buffer, sizeof(buffer))) > 0) {
+        fwrite(buffer, 1, (size_t)received, stdout);
+        fflush(stdout);
+    }
+    close(fd);
+    printf("\nBroadcast ended.\n");
+    return 0;
+}
+
+// --- Replays and digest logs ---
+
+typedef struct {
+    char kind; // 'c' config, 'g' new game, otherwise the command
+    uint32_t seed;
+    GameConfig config;
+    uint64_t digest;
+} ReplayEntry;
+
+typedef struct {
+    int count;
+    ReplayEntry* entries;
+} ReplayLog;
+
+static int load_replay(const char* path, ReplayLog* log) {
+    FILE* fp = fopen(path, "r");
+    char line[128];
+    int capacity = 0;
+
+    memset(log, 0, sizeof(*log));
+    if (!fp) return -1;
+    if (!fgets(line, sizeof(line), fp) || strncmp(line, "moon-lander-replay 1", 20) != 0) {
+        fclose(fp);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        ReplayEntry entry;
+        unsigned long long digest = 0;
+        char command;
+        memset(&entry, 0, sizeof(entry));
+
+        entry.config = (GameConfig)DEFAULT_GAME_CONFIG; // Older recordings omit the touchdown limits
+        if (sscanf(line, "config %lf %lf %d %lf %lf %lf", &entry.config.gravity, &entry.config.engine_force,
+                   &entry.config.initial_fuel, &entry.config.safe_vertical_speed, &entry.config.safe_horizontal_speed,
+                   &entry.config.terrain_penalty) >= 3) {
+            entry.kind = 'c';
+        } else if (sscanf(line, "game %u %llx", &entry.seed, &digest) == 2) {
+            entry.kind = 'g';
+        } else if (sscanf(line, " %c %llx", &command, &digest) == 2) {
+            entry.kind = command;
+        } else {
+            continue;
+        }
+        entry.digest = digest;
+
+        if (log->count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            ReplayEntry* grown = realloc(log->entries, (size_t)capacity * sizeof(ReplayEntry));
+            if (!grown) {
+                fclose(fp);
+                return -1;
+            }
+            log->entries = grown;
+        }
+        log->entries[log->count++] = entry;
+    }
+    fclose(fp);
+    return 0;
+}
+
+// Digest-bearing entries (games and commands) only, in order
+static uint64_t* replay_digests(ReplayLog* log, int** positions, int* count) {
+    uint64_t* digests = malloc((size_t)(log->count + 1) * sizeof(uint64_t));
+    *positions = malloc((size_t)(log->count + 1) * sizeof(int));
+    *count = 0;
+    if (!digests || !*positions) return digests;
+    for (int i = 0; i < log->count; i++) {
+        if (log->entries[i].kind == 'c') continue;
+        (*positions)[*count] = i;
+        digests[(*count)++] = log->entries[i].digest;
+    }
+    return digests;
+}
+
+// Index of the first differing digest, or count if the logs agree
+int first_divergence(const uint64_t* a, const uint64_t* b, int count) {
+    int lo = 0, hi = count; // Digests before lo match; the first mismatch is < hi
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (a[mid] == b[mid]) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static void describe_replay_position(ReplayLog* log, int position) {
+    int game = 0, turn = 0;
+    for (int i = 0; i <= position; i++) {
+        if (log->entries[i].kind == 'g') {
+            game++;
+            turn = 0;
+        } else if (log->entries[i].kind != 'c') {
+            turn++;
+        }
+    }
+    if (log->entries[position].kind == 'g') {
+        printf("game %d start (seed %u)", game, log->entries[position].seed);
+    } else {
+        printf("game %d, turn %d (command %c)", game, turn, log->entries[position].kind);
+    }
+}
+
+int run_replay(const char* path) {
+    ReplayLog log;
+    if (load_replay(path, &log) != 0) {
+        printf("Error: Could not read replay %s.\n", path);
+        free(log.entries);
+        return 1;
+    }
+
+    // Re-simulate, overwriting each digest with the one this build computes
+    ReplayLog computed = {log.count, malloc((size_t)log.count * sizeof(ReplayEntry) + 1)};
+    Session session;
+    GameConfig config = DEFAULT_GAME_CONFIG;
+    init_session(&session, &config, 1);
+    for (int i = 0; computed.entries && i < log.count; i++) {
+        ReplayEntry* entry = &log.entries[i];
+        computed.entries[i] = *entry;
+        if (entry->kind == 'c') {
+            session.config.gravity = entry->config.gravity;
+            session.config.engine_force = entry->config.engine_force;
+            session.config.initial_fuel = entry->config.initial_fuel;
+            session.config.safe_vertical_speed = entry->config.safe_vertical_speed;
+            session.config.safe_horizontal_speed = entry->config.safe_horizontal_speed;
+            session.config.terrain_penalty = entry->config.terrain_penalty;
+            continue;
+        }
+        if (entry->kind == 'g') session_start(&session, entry->seed);
+        else session_command(&session, entry->kind);
+        computed.entries[i].digest = session.digest;
+    }
+
+    int count, ignored, *positions = NULL, *computed_positions = NULL;
+    uint64_t* recorded = replay_digests(&log, &positions, &count);
+    uint64_t* replayed = computed.entries ? replay_digests(&computed, &computed_positions, &ignored) : NULL;
+    int status = 1;
+    if (recorded && replayed && positions && computed_positions) {
+        int divergence = first_divergence(recorded, replayed, count);
+        if (divergence == count) {
+            printf("Replay %s: all %d turns match.\n", path, count);
+            status = 0;
+        } else {
+            printf("Replay %s diverges at ", path);
+            describe_replay_position(&log, positions[divergence]);
+            printf(": recorded %016llx, replayed %016llx\n", (unsigned long long)recorded[divergence],
+                   (unsigned long long)replayed[divergence]);
+        }
+    } else {
+        printf("Error: Out of memory replaying %s.\n", path);
+    }
+
+    free(recorded);
+    free(replayed);
+    free(positions);
+    free(computed_positions);
+    free(computed.entries);
+    free(log.entries);
+    return status;
+}
+
+int run_digest_diff(const char* path_a, const char* path_b) {
+    ReplayLog a, b;
+    int loaded_a = load_replay(path_a, &a) == 0, loaded_b = load_replay(path_b, &b) == 0;
+    int status = 1;
+    if (!loaded_a || !loaded_b) {
+        printf("Error: Could not read %s.\n", loaded_a ? path_b : path_a);
+        free(a.entries);
+        free(b.entries);
+        return 1;
+    }
+
+    int count_a, count_b, *positions_a = NULL, *positions_b = NULL;
+    uint64_t* digests_a = replay_digests(&a, &positions_a, &count_a);
+    uint64_t* digests_b = replay_digests(&b, &positions_b, &count_b);
+    if (digests_a && digests_b && positions_a && positions_b) {
+        int common = count_a < count_b ? count_a : count_b;
+        int divergence = first_divergence(digests_a, digests_b, common);
+        if (divergence < common) {
+            printf("First divergence: ");
+            describe_replay_position(&a, positions_a[divergence]);
+            printf(" in %s\n", path_a);
+        } else if (count_a != count_b) {
+            printf("Recordings agree for %d turns; %s is longer.\n", common, count_a > count_b ? path_a : path_b);
+            status = 0;
+        } else {
+            printf("Recordings agree on all %d turns.\n", common);
+            status = 0;
+        }
+    } else {
+        printf("Error: Out of memory comparing recordings.\n");
+    }
+
+    free(digests_a);
+    free(digests_b);
+    free(positions_a);
+    free(positions_b);
+    free(a.entries);
+    free(b.entries);
+    return status;
+}
+